@@ -6,7 +6,7 @@ QMAKE_LFLAGS   += -std=c++17
 INCLUDEPATH    += ../lib/cul/inc 
 #                 have to use absolute file paths
 LIBS           += "-L$$PWD/../lib/cul" 
-LIBS           += -lcap -lcommon-d -lncurses
+LIBS           += -lcap -lcommon-d -lncurses -lpthread
                   
 
 DEFINES += MACRO_COMPILER_GCC
@@ -17,12 +17,29 @@ SOURCES += \
     ../src/AppStateDefs.cpp \
     ../src/NCursesGrid.cpp \
     ../src/MemoryReader.cpp \
+    ../src/CachingMemoryReader.cpp \
+    ../src/SnapshotMemoryReader.cpp \
+    ../src/ProcessMaps.cpp \
+    ../src/MemoryScanner.cpp \
+    ../src/ScanCandidates.cpp \
+    ../src/PointerChain.cpp \
+    ../src/ReadPlanner.cpp \
+    ../src/ReadProfile.cpp \
+    ../src/FaultInjectingMemoryReader.cpp \
+    ../src/MemorySampler.cpp \
+    ../src/RecordingMemoryReader.cpp \
+    ../src/CaptureFile.cpp \
+    ../src/AllocationCount.cpp \
+    ../src/RefreshArena.cpp \
+    ../src/Benchmarks.cpp \
     \ # PSO Item Reader
     ../src/pso/ItemDb.cpp \
     ../src/pso/Item.cpp \
     ../src/pso/ItemReader.cpp \
     ../src/pso/ItemReaderBaseState.cpp \
     ../src/pso/ItemReaderStates.cpp \
+    ../src/pso/ItemTracker.cpp \
+    ../src/pso/ClientWorker.cpp \
     ../src/pso/ProcessWatcher.cpp
 
 
@@ -31,10 +48,29 @@ HEADERS += \
     ../src/AppStateDefs.hpp \
     ../src/NCursesGrid.hpp \
     ../src/MemoryReader.hpp \
+    ../src/CachingMemoryReader.hpp \
+    ../src/SnapshotMemoryReader.hpp \
+    ../src/ProcessMaps.hpp \
+    ../src/MemoryScanner.hpp \
+    ../src/ScanCandidates.hpp \
+    ../src/PointerChain.hpp \
+    ../src/ReadPlanner.hpp \
+    ../src/ReadProfile.hpp \
+    ../src/FaultInjectingMemoryReader.hpp \
+    ../src/MemorySampler.hpp \
+    ../src/SpscRing.hpp \
+    ../src/RecordingMemoryReader.hpp \
+    ../src/CaptureFile.hpp \
+    ../src/AllocationCount.hpp \
+    ../src/RefreshArena.hpp \
+    ../src/Benchmarks.hpp \
     \ # PSO Item Reader
     ../src/pso/ItemDb.hpp \
     ../src/pso/Item.hpp \
     ../src/pso/ItemReader.hpp \
+    ../src/pso/ItemValue.hpp \
     ../src/pso/ItemReaderBaseState.hpp \
     ../src/pso/ItemReaderStates.hpp \
+    ../src/pso/ItemTracker.hpp \
+    ../src/pso/ClientWorker.hpp \
     ../src/pso/ProcessWatcher.hpp
@@ -0,0 +1,60 @@
+/****************************************************************************
+
+    File: AllocationCount.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "AllocationCount.hpp"
+
+#ifdef MACRO_COUNT_ALLOCATIONS
+
+#include <new>
+
+#include <cstdlib>
+
+namespace {
+
+// per thread, so that counting costs nothing more than an increment and
+// other threads' allocations don't muddle a measurement
+thread_local std::size_t t_allocation_count = 0;
+
+} // end of <anonymous> namespace
+
+// every other allocating form (arrays, nothrow, sized deletes) forwards to
+// these by default, aligned forms are left alone, and not counted
+void * operator new(std::size_t size) {
+    ++t_allocation_count;
+    if (size == 0) size = 1;
+    while (true) {
+        if (void * ptr = std::malloc(size)) return ptr;
+        auto handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+
+/* free fn */ std::size_t thread_allocation_count() noexcept
+    { return t_allocation_count; }
+
+#else
+
+/* free fn */ std::size_t thread_allocation_count() noexcept { return 0; }
+
+#endif
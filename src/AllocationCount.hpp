@@ -0,0 +1,38 @@
+/****************************************************************************
+
+    File: AllocationCount.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+/** @returns the number of heap allocations the calling thread has made
+ *           through global operator new, always zero unless built with
+ *           MACRO_COUNT_ALLOCATIONS (which replaces operator new)
+ */
+std::size_t thread_allocation_count() noexcept;
+
+constexpr bool is_counting_allocations() noexcept {
+#   ifdef MACRO_COUNT_ALLOCATIONS
+    return true;
+#   else
+    return false;
+#   endif
+}
@@ -0,0 +1,685 @@
+/****************************************************************************
+
+    File: Benchmarks.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "Benchmarks.hpp"
+#include "MemoryScanner.hpp"
+#include "RecordingMemoryReader.hpp"
+#include "CaptureFile.hpp"
+#include "FaultInjectingMemoryReader.hpp"
+#include "ReadPlanner.hpp"
+#include "ReadProfile.hpp"
+#include "SnapshotMemoryReader.hpp"
+#include "AllocationCount.hpp"
+
+#include "pso/ItemReaderStates.hpp"
+#include "pso/ClientWorker.hpp"
+#include "pso/ItemValue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#endif
+
+namespace {
+
+using AppStatePtr = std::shared_ptr<AppState>;
+using AppStateMap = AppState::AppStateMap;
+
+struct ReplayRun {
+    // spent ticking and rendering (and recovering)
+    double seconds    = 0.;
+    int    ticks      = 0;
+    // times the view gave up, and was set up again
+    int    recoveries = 0;
+};
+
+/** Plays a recording back through a view's whole tick and render path, as
+ *  fast as possible but with the same ticks for every run.
+ *  @param faults if given, injected into every read of the recording
+ */
+template <typename ViewType>
+ReplayRun run_replay_benchmark(const char * filename, const FaultProfile * faults);
+
+struct StorageRun {
+    double        seconds     = 0.;
+    uint64_t      cycles      = 0;
+    std::size_t   allocations = 0;
+    int           refreshes   = 0;
+};
+
+struct StorageComparison {
+    StorageRun pointers; // ItemList
+    StorageRun values;   // ItemValueList
+};
+
+/** Decodes and prints every list of a recording both as an ItemList and as
+ *  an ItemValueList, from a snapshot taken each tick (not timed).
+ *  @returns runs for the inventory, floor and bank, in that order
+ */
+std::array<StorageComparison, 3> run_storage_benchmark(const char * filename);
+
+struct DecodeRun {
+    double      seconds = 0.;
+    uint64_t    cycles  = 0;
+    std::size_t items   = 0;
+    // record bytes the items were decoded from
+    std::size_t bytes   = 0;
+};
+
+/** Decodes every item record of a recording straight out of a snapshot
+ *  taken each tick (not timed), with no reads and no printing, so that only
+ *  the decoders themselves are measured.
+ *  @returns runs for inventory and floor items, and for bank items
+ */
+std::array<DecodeRun, 2> run_decode_benchmark(const char * filename);
+
+struct BackendTiming {
+    // microseconds per read, with one read call each and with every read of
+    // a pass in one read_batch
+    double single_us = 0.;
+    double batch_us  = 0.;
+};
+
+struct ReadGridCell {
+    std::size_t   read_size  = 0;
+    std::size_t   read_count = 0;
+    BackendTiming vm_readv;
+    BackendTiming proc_mem;
+};
+
+/** Times both process reader backends (process_vm_readv and
+ *  /proc/<pid>/mem) reading a forked child's copy of a known buffer, over a
+ *  grid of read sizes and reads per pass.
+ *  @throws if the child cannot be started, or a backend reads back the
+ *          wrong bytes
+ */
+std::vector<ReadGridCell> run_read_benchmark();
+
+struct RefreshCost {
+    // per refresh
+    double      us       = 0.;
+    std::size_t syscalls = 0;
+};
+
+struct RefreshComparison {
+    RefreshCost per_field;
+    RefreshCost batched;
+};
+
+/** Reads the fields of every record of a full bank held by a forked child,
+ *  once with a read per field (as decoders did before read_batch) and once
+ *  with every field in one read_batch.
+ *  @returns costs for process_vm_readv and for /proc/<pid>/mem, in that
+ *           order
+ */
+std::array<RefreshComparison, 2> run_refresh_syscall_benchmark();
+
+/** A forked copy of this process that does nothing but wait to be read, and
+ *  is killed when this goes away.
+ */
+class PausedChild {
+public:
+    PausedChild();
+    PausedChild(const PausedChild &) = delete;
+    PausedChild & operator = (const PausedChild &) = delete;
+    ~PausedChild();
+
+    int pid() const noexcept { return m_pid; }
+
+private:
+    int m_pid;
+};
+
+/** @returns the time stamp counter, or zero where there is none */
+uint64_t read_cycle_counter();
+
+/** Decodes a weapon record next to one with a junk special byte, both as a
+ *  list and one at a time.
+ *  @returns true if only the good record came back
+ */
+bool run_decode_check();
+
+} // end of <anonymous> namespace
+
+bool run_requested_benchmark() {
+    // APIR_SCAN_BENCHMARK=<thread count> (zero for one per hardware thread)
+    if (const char * threads = std::getenv("APIR_SCAN_BENCHMARK")) {
+        auto stats = run_scanner_benchmark(std::atoi(threads));
+        std::cout << "scanned " << stats.bytes_scanned << " bytes, in "
+                  << stats.seconds << " seconds (" << stats.gigabytes_per_second()
+                  << " GB/s), " << stats.hits << " hits" << std::endl;
+        return true;
+    }
+    // APIR_CAPTURE_STATS=session.apircap (from APIR_CAPTURE)
+    if (const char * filename = std::getenv("APIR_CAPTURE_STATS")) {
+        auto stats = measure_capture(filename);
+        std::cout << stats.frame_count << " frames (" << stats.keyframe_count
+                  << " keyframes), " << stats.raw_bytes << " bytes as full dumps, "
+                  << stats.file_bytes << " bytes on disk (ratio "
+                  << stats.compression_ratio() << "), decoded at "
+                  << stats.decode_megabytes_per_second() << " MB/s" << std::endl;
+        return true;
+    }
+    // APIR_REPLAY_BENCHMARK=session.apirrec (from APIR_RECORD)
+    if (const char * filename = std::getenv("APIR_REPLAY_BENCHMARK")) {
+        auto report = [](const char * view, const ReplayRun & run) {
+            auto plans = ReadPlanner::total_stats();
+            ReadPlanner::reset_total_stats();
+            auto refreshes = ClientWorker::total_refresh_stats();
+            ClientWorker::reset_total_refresh_stats();
+            std::cout << view << ": " << run.ticks << " ticks in " << run.seconds
+                      << " seconds (" << (run.ticks ? run.seconds*1e6 / run.ticks : 0.)
+                      << " us per tick, " << run.recoveries << " recoveries)\n    "
+                      << plans.ranges << " ranges in "
+                      << plans.reads << " reads (" << plans.reads_saved()
+                      << " saved), " << plans.bytes_over_read << " of "
+                      << plans.bytes_requested << " bytes over-read" << std::endl;
+            // once warmed up, refreshes should make no allocations at all
+            if (!is_counting_allocations()) return;
+            std::cout << "    " << refreshes.allocations << " heap allocations in "
+                      << refreshes.allocating_refreshes << " of "
+                      << refreshes.refreshes << " refreshes" << std::endl;
+        };
+        // e.g. APIR_FAULTS=bad=0.01,torn=0.01 to see how the views cope
+        std::unique_ptr<FaultProfile> faults;
+        if (const char * settings = std::getenv("APIR_FAULTS")) {
+            faults = std::make_unique<FaultProfile>(FaultProfile::parse(settings));
+        }
+        ReadPlanner::reset_total_stats();
+        ClientWorker::reset_total_refresh_stats();
+        report("inventory", run_replay_benchmark<InventoryViewState>(filename, faults.get()));
+        report("floor"    , run_replay_benchmark<FloorViewState    >(filename, faults.get()));
+        report("bank"     , run_replay_benchmark<BankViewState     >(filename, faults.get()));
+        return true;
+    }
+    // APIR_STORAGE_BENCHMARK=session.apirrec (from APIR_RECORD)
+    if (const char * filename = std::getenv("APIR_STORAGE_BENCHMARK")) {
+        auto report_run = [](const char * storage, const StorageRun & run) {
+            auto per = [&run](double x) { return run.refreshes ? x / run.refreshes : 0.; };
+            std::cout << "    " << storage << ": " << per(run.seconds*1e6)
+                      << " us, " << per(double(run.cycles)) << " cycles, ";
+            if (is_counting_allocations()) {
+                std::cout << per(double(run.allocations)) << " allocations";
+            } else {
+                std::cout << "allocations not counted (build with MACRO_COUNT_ALLOCATIONS)";
+            }
+            std::cout << " per refresh" << std::endl;
+        };
+        auto runs = run_storage_benchmark(filename);
+        const char * const names[] = { "inventory", "floor", "bank" };
+        for (std::size_t i = 0; i != runs.size(); ++i) {
+            std::cout << names[i] << " (" << runs[i].values.refreshes
+                      << " refreshes)" << std::endl;
+            report_run("unique_ptr<Item>", runs[i].pointers);
+            report_run("variant values  ", runs[i].values);
+        }
+        return true;
+    }
+    // APIR_READ_BENCHMARK=1 (any value)
+    if (std::getenv("APIR_READ_BENCHMARK")) {
+        auto cells = run_read_benchmark();
+        std::cout << "us per read     process_vm_readv   /proc/<pid>/mem\n"
+                  << "   size count    single    batch    single    batch\n";
+        for (const auto & cell : cells) {
+            std::cout << std::setw(7) << cell.read_size << std::setw(6) << cell.read_count
+                      << std::fixed << std::setprecision(3)
+                      << std::setw(10) << cell.vm_readv.single_us
+                      << std::setw(9 ) << cell.vm_readv.batch_us
+                      << std::setw(10) << cell.proc_mem.single_us
+                      << std::setw(9 ) << cell.proc_mem.batch_us
+                      << std::defaultfloat << std::setprecision(6) << '\n';
+        }
+        auto refreshes = run_refresh_syscall_benchmark();
+        const char * const backends[] = { "process_vm_readv", "/proc/<pid>/mem" };
+        for (std::size_t i = 0; i != refreshes.size(); ++i) {
+            const auto & refresh = refreshes[i];
+            std::cout << "full bank refresh, " << backends[i] << ": "
+                      << refresh.per_field.syscalls << " syscalls ("
+                      << refresh.per_field.us << " us) a field at a time, "
+                      << refresh.batched.syscalls << " syscalls ("
+                      << refresh.batched.us << " us) batched\n";
+        }
+        std::cout << std::flush;
+        return true;
+    }
+    // APIR_DECODE_BENCHMARK=session.apirrec (from APIR_RECORD)
+    if (const char * filename = std::getenv("APIR_DECODE_BENCHMARK")) {
+        auto report = [](const char * records, const DecodeRun & run) {
+            auto per = [&run](double x) { return run.items ? x / run.items : 0.; };
+            std::cout << records << ": " << run.items << " items, "
+                      << per(run.seconds*1e9) << " ns, " << per(double(run.cycles))
+                      << " cycles per item ("
+                      << (run.seconds > 0. ? run.bytes / run.seconds / 1e6 : 0.)
+                      << " MB/s of records)" << std::endl;
+        };
+        auto runs = run_decode_benchmark(filename);
+        report("inventory and floor", runs[0]);
+        report("bank"               , runs[1]);
+        return true;
+    }
+    if (std::getenv("APIR_DECODE_CHECK")) {
+        bool passed = run_decode_check();
+        std::cout << "decode check " << (passed ? "passed" : "FAILED") << std::endl;
+        if (!passed) std::exit(EXIT_FAILURE);
+        return true;
+    }
+    return false;
+}
+
+namespace {
+
+template <typename ViewType>
+ReplayRun run_replay_benchmark(const char * filename, const FaultProfile * faults) {
+    // same tick length as the main loop
+    static constexpr const double k_tick = 0.04;
+
+    class MemoryGrid final : public TargetGrid {
+    public:
+        int width () const override { return 80; }
+        int height() const override { return 50; }
+        void set_cell(int x, int y, char c, int) override
+            { m_cells[std::size_t(y*width() + x)] = c; }
+    private:
+        std::array<char, 80*50> m_cells {};
+    };
+
+    auto replay = std::make_shared<ReplayMemoryReader>(filename, 0.);
+    std::shared_ptr<const MemoryReader> memory = replay;
+    if (faults) {
+        memory = std::make_shared<FaultInjectingMemoryReader>(replay, *faults);
+    }
+    AppStateMap statemap;
+    MemoryGrid grid;
+    // as the process watcher would, when a view gives up
+    auto start_view = [&statemap, &memory, &grid]() {
+        auto view = AppState::make_state_with_map<ViewType>(statemap);
+        // a fault may well hit the first read
+        try {
+            view->setup(memory);
+        } catch (std::exception &) {}
+        AppStatePtr state = view;
+        state->handle_resize(grid);
+        return state;
+    };
+    auto state = start_view();
+
+    using Clock = std::chrono::steady_clock;
+    ReplayRun rv;
+    for (double t = 0.; t <= replay->duration(); t += k_tick) {
+        replay->advance_to(t);
+        auto start = Clock::now();
+        state->handle_tick(k_tick);
+        if (state->get_new_state()) {
+            state = start_view();
+            ++rv.recoveries;
+        }
+        state->render_to(grid);
+        rv.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        ++rv.ticks;
+    }
+    return rv;
+}
+
+std::array<StorageComparison, 3> run_storage_benchmark(const char * filename) {
+    // same tick length as the main loop
+    static constexpr const double k_tick = 0.04;
+
+    using Clock = std::chrono::steady_clock;
+    // the first refresh of each is left out, so that only steady state
+    // refreshes (with warm buffers) are counted
+    auto measure = [](StorageRun & run, bool counted, auto && refresh) {
+        auto allocations = thread_allocation_count();
+        auto start       = Clock::now();
+        auto cycles      = read_cycle_counter();
+        refresh();
+        if (!counted) return;
+        run.cycles      += read_cycle_counter() - cycles;
+        run.seconds     += std::chrono::duration<double>(Clock::now() - start).count();
+        run.allocations += thread_allocation_count() - allocations;
+        ++run.refreshes;
+    };
+
+    ReplayMemoryReader replay(filename, 0.);
+    ItemGlobals globals;
+    MemoryRegionList regions;
+    AddressList addresses;
+    ItemValueList values;
+    std::ostringstream out;
+    std::array<StorageComparison, 3> rv;
+    const ItemPtrUpdater updaters[] = {
+        update_inventory_pointers, update_floor_pointers, update_bank_pointers
+    };
+    bool counted = false;
+    for (double t = 0.; t <= replay.duration(); t += k_tick) {
+        replay.advance_to(t);
+        std::shared_ptr<const MemorySnapshot> snapshot;
+        try {
+            regions.clear();
+            collect_item_regions(replay, regions);
+            snapshot = MemorySnapshot::take(replay, regions);
+            globals.update(*snapshot);
+        } catch (std::exception &) {
+            // nothing in the recording for this tick
+            continue;
+        }
+        for (std::size_t i = 0; i != rv.size(); ++i) {
+            try {
+                updaters[i](*snapshot, globals, addresses);
+                measure(rv[i].pointers, counted, [&]() {
+                    out.seekp(0);
+                    ItemList items;
+                    switch (i) {
+                    case 0 : items = load_inventory(*snapshot, addresses); break;
+                    case 1 : items = load_floor    (*snapshot, addresses); break;
+                    default: items = load_bank     (*snapshot, globals, addresses); break;
+                    }
+                    for (const auto & item : items) item->print_to(out);
+                });
+                measure(rv[i].values, counted, [&]() {
+                    out.seekp(0);
+                    switch (i) {
+                    case 0 : load_inventory_values(*snapshot, addresses, values); break;
+                    case 1 : load_floor_values    (*snapshot, addresses, values); break;
+                    default: load_bank_values     (*snapshot, globals, addresses, values); break;
+                    }
+                    for (const auto & item : values) print_item(out, item);
+                });
+            } catch (std::exception &) {
+                // this list isn't there in this tick
+            }
+        }
+        counted = true;
+    }
+    return rv;
+}
+
+std::array<DecodeRun, 2> run_decode_benchmark(const char * filename) {
+    // same tick length as the main loop
+    static constexpr const double k_tick = 0.04;
+    // each tick's records are decoded this many times over, so that the
+    // clock's own cost is lost in the noise
+    static constexpr const int k_passes = 16;
+
+    using Clock = std::chrono::steady_clock;
+    using DecodeFunc = bool (*)(const ByteSpan &, Address, ItemValue &, const MemoryReader *);
+
+    ReplayMemoryReader replay(filename, 0.);
+    ItemGlobals globals;
+    MemoryRegionList regions;
+    AddressList addresses, floor_addresses;
+    std::vector<ByteSpan> records;
+    ItemValue item;
+    std::array<DecodeRun, 2> rv;
+    auto measure = [&](DecodeRun & run, DecodeFunc decode, std::size_t record_size) {
+        auto start  = Clock::now();
+        auto cycles = read_cycle_counter();
+        std::size_t decoded = 0;
+        for (int pass = 0; pass != k_passes; ++pass) {
+            for (std::size_t i = 0; i != records.size(); ++i) {
+                if (decode(records[i], addresses[i], item, nullptr)) ++decoded;
+            }
+        }
+        run.cycles  += read_cycle_counter() - cycles;
+        run.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        run.items   += decoded;
+        run.bytes   += decoded*record_size;
+    };
+    for (double t = 0.; t <= replay.duration(); t += k_tick) {
+        replay.advance_to(t);
+        std::shared_ptr<const MemorySnapshot> snapshot;
+        try {
+            regions.clear();
+            collect_item_regions(replay, regions);
+            snapshot = MemorySnapshot::take(replay, regions);
+            globals.update(*snapshot);
+        } catch (std::exception &) {
+            // nothing in the recording for this tick
+            continue;
+        }
+        try {
+            // inventory and floor items share one record layout, every
+            // record is decoded in place, out of the snapshot's own bytes
+            using InventoryLayout::k_record;
+            update_inventory_pointers(*snapshot, globals, addresses);
+            update_floor_pointers    (*snapshot, globals, floor_addresses);
+            addresses.insert(addresses.end(), floor_addresses.begin(), floor_addresses.end());
+            records.clear();
+            for (auto addr : addresses) {
+                // a record the snapshot lacks is an empty span, and is left out
+                auto data = snapshot->view(addr + k_record.begin, k_record.size());
+                records.push_back(ByteSpan { addr + k_record.begin, data,
+                                             data ? k_record.size() : 0 });
+            }
+            measure(rv[0], decode_inventory_value, k_record.size());
+        } catch (std::exception &) {
+            // these lists aren't there in this tick
+        }
+        try {
+            // the whole bank block (kill counters and all) is one region
+            using namespace BankLayout;
+            update_bank_pointers(*snapshot, globals, addresses);
+            auto bank_ptr = globals.bank_pointer();
+            const auto & regions_taken = snapshot->regions();
+            auto block = std::find_if(regions_taken.begin(), regions_taken.end(),
+                [bank_ptr](const MemoryRegion & region)
+                { return region.address <= bank_ptr && bank_ptr < region.end(); });
+            if (!bank_ptr || block == regions_taken.end()) continue;
+            ByteSpan bank { block->address, snapshot->view(block->address, block->length),
+                            block->length };
+            records.assign(addresses.size(), bank);
+            measure(rv[1], decode_bank_value, k_record_size);
+        } catch (std::exception &) {
+            // the bank isn't there in this tick
+        }
+    }
+    return rv;
+}
+
+std::vector<ReadGridCell> run_read_benchmark() {
+    static constexpr const std::size_t k_buffer_size  = std::size_t(16) << 20;
+    static constexpr const std::size_t k_read_sizes[] = { 4, 64, 512, 4096, 65536 };
+    static constexpr const std::size_t k_read_counts[] = { 1, 16, 256 };
+    // each cell reads about this many bytes per backend and mode, within
+    // these many passes
+    static constexpr const std::size_t k_bytes_per_cell = std::size_t(64) << 20;
+    static constexpr const std::size_t k_min_passes = 4;
+    static constexpr const std::size_t k_max_passes = 2000;
+
+    using Clock = std::chrono::steady_clock;
+    auto elapsed_us = [](Clock::time_point start)
+        { return std::chrono::duration<double, std::micro>(Clock::now() - start).count(); };
+
+    // the child's copy of the buffer sits at the very same addresses
+    std::vector<uint8_t> buffer(k_buffer_size);
+    for (std::size_t i = 0; i != buffer.size(); ++i) {
+        buffer[i] = uint8_t(i*31 + (i >> 8));
+    }
+    PausedChild child;
+    auto vm_readv = MemoryReader::make_process_reader(child.pid(), MemoryReader::k_process_vm_readv);
+    auto proc_mem = MemoryReader::make_process_reader(child.pid(), MemoryReader::k_proc_pid_mem);
+
+    ReadRequestList requests;
+    std::vector<uint8_t> destination;
+    auto time_reads = [&](const MemoryReader & memory, std::size_t passes) {
+        BackendTiming rv;
+        auto start = Clock::now();
+        for (std::size_t pass = 0; pass != passes; ++pass) {
+            for (const auto & req : requests) {
+                memory.read(req.address, req.destination, req.length);
+            }
+        }
+        rv.single_us = elapsed_us(start) / double(passes*requests.size());
+        start = Clock::now();
+        for (std::size_t pass = 0; pass != passes; ++pass) {
+            memory.read_batch(requests);
+        }
+        rv.batch_us = elapsed_us(start) / double(passes*requests.size());
+
+        for (const auto & req : requests) {
+            auto offset = req.address - Address(reinterpret_cast<std::uintptr_t>(buffer.data()));
+            if (std::memcmp(req.destination, buffer.data() + offset, req.length) != 0) {
+                throw std::runtime_error("run_read_benchmark: read back bytes that are not the child's.");
+            }
+        }
+        return rv;
+    };
+
+    std::vector<ReadGridCell> rv;
+    for (auto size : k_read_sizes) {
+    for (auto count : k_read_counts) {
+        // spread over the whole buffer, rather than reading the same lines
+        // over and over
+        auto stride = (k_buffer_size - size) / count;
+        destination.assign(size*count, 0);
+        requests.clear();
+        for (std::size_t i = 0; i != count; ++i) {
+            requests.push_back(ReadRequest {
+                Address(reinterpret_cast<std::uintptr_t>(buffer.data() + i*stride)),
+                destination.data() + i*size, size });
+        }
+        auto passes = std::clamp(k_bytes_per_cell / (size*count), k_min_passes, k_max_passes);
+
+        ReadGridCell cell;
+        cell.read_size  = size;
+        cell.read_count = count;
+        cell.vm_readv   = time_reads(*vm_readv, passes);
+        cell.proc_mem   = time_reads(*proc_mem, passes);
+        rv.push_back(cell);
+    }}
+    return rv;
+}
+
+std::array<RefreshComparison, 2> run_refresh_syscall_benchmark() {
+    using namespace BankLayout;
+    static constexpr const std::size_t k_bank_slots = 200;
+    static constexpr const int k_refreshes = 50;
+    // about what decoding a weapon used to read
+    static constexpr const FieldLayout k_fields[] = {
+        k_fullcode, k_weapon_grind, k_weapon_special, k_weapon_attributes, k_dfp, k_evp };
+
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<uint8_t> bank(k_first_record + k_record_size*k_bank_slots);
+    bank[k_item_count.offset] = uint8_t(k_bank_slots);
+    auto bank_ptr = Address(reinterpret_cast<std::uintptr_t>(bank.data()));
+    PausedChild child;
+
+    std::vector<uint8_t> destination(bank.size());
+    ReadRequestList requests;
+    for (std::size_t i = 0; i != k_bank_slots; ++i) {
+        Address record = k_first_record + k_record_size*i;
+        for (const auto & field : k_fields) {
+            requests.push_back(ReadRequest {
+                bank_ptr + record + field.offset, destination.data() + record + field.offset,
+                field.width });
+        }
+    }
+    auto measure = [&requests](auto && refresh) {
+        auto syscalls = read_memory_syscall_count();
+        auto start    = Clock::now();
+        for (int i = 0; i != k_refreshes; ++i) refresh();
+        RefreshCost rv;
+        rv.us       = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / k_refreshes;
+        rv.syscalls = (read_memory_syscall_count() - syscalls) / k_refreshes;
+        return rv;
+    };
+
+    std::array<RefreshComparison, 2> rv;
+    const MemoryReader::ProcessReadMethod methods[] = {
+        MemoryReader::k_process_vm_readv, MemoryReader::k_proc_pid_mem };
+    for (std::size_t i = 0; i != rv.size(); ++i) {
+        auto memory = MemoryReader::make_process_reader(child.pid(), methods[i]);
+        rv[i].per_field = measure([&]() {
+            for (const auto & req : requests) memory->read(req.address, req.destination, req.length);
+        });
+        rv[i].batched = measure([&]() { memory->read_batch(requests); });
+    }
+    return rv;
+}
+
+PausedChild::PausedChild():
+    m_pid(int(fork()))
+{
+    if (m_pid < 0) {
+        throw std::runtime_error("PausedChild: could not fork a child to read from.");
+    }
+    if (m_pid == 0) {
+        // killed by the parent, it never gets past this
+        for (;;) pause();
+    }
+}
+
+PausedChild::~PausedChild() {
+    kill(m_pid, SIGKILL);
+    waitpid(m_pid, nullptr, 0);
+}
+
+bool run_decode_check() {
+    using namespace InventoryLayout;
+    static constexpr const Address k_base = 0x10000;
+    static constexpr const Address k_good = k_base;
+    static constexpr const Address k_bad  = k_base + 0x200;
+
+    std::vector<uint8_t> block(0x400, 0);
+    auto put = [&block](Address addr, FieldLayout field, uint32_t value)
+        { std::memcpy(block.data() + (addr - k_base + field.offset), &value, field.width); };
+    for (auto addr : { k_good, k_bad }) {
+        // a saber, grinded +3
+        put(addr, k_fullcode, 0x00'01'00);
+        put(addr, k_weapon_grind, 3);
+    }
+    // past the last special, as a half written or stale record may hold
+    put(k_bad, k_weapon_special, 0xFF);
+
+    LocalBlockReader memory(k_base, block.data(), block.size());
+    ItemValueList items;
+    load_inventory_values(memory, AddressList { k_bad, k_good }, items);
+    bool list_ok = items.size() == 1 && as_item(items.front()).source_address() == k_good;
+
+    ByteSpan bytes { k_base, block.data(), block.size() };
+    ItemValue item;
+    bool single_ok =    decode_inventory_value(bytes, k_good, item)
+                     && !decode_inventory_value(bytes, k_bad, item)
+                     && !load_inventory_value(memory, k_bad, item);
+    return list_ok && single_ok;
+}
+
+uint64_t read_cycle_counter() {
+#   if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#   else
+    return 0;
+#   endif
+}
+
+} // end of <anonymous> namespace
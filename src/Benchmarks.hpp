@@ -0,0 +1,28 @@
+/****************************************************************************
+
+    File: Benchmarks.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+/** Runs a benchmark or self check, if one is asked for by the environment
+ *  (see the README for which).
+ *  @returns true if one was run
+ */
+bool run_requested_benchmark();
@@ -0,0 +1,181 @@
+/****************************************************************************
+
+    File: CachingMemoryReader.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "CachingMemoryReader.hpp"
+
+#include <algorithm>
+
+#include <cassert>
+
+CachingMemoryReader::CachingMemoryReader
+    (std::shared_ptr<const MemoryReader> source):
+    m_source(source)
+{
+    if (!m_source) {
+        throw std::invalid_argument("CachingMemoryReader::CachingMemoryReader: "
+                                    "source reader must not be null.");
+    }
+}
+
+void CachingMemoryReader::read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const
+{
+    if (copy_from_pages(addr, buf, bytes_in_buf)) return;
+    m_source->read(addr, buf, bytes_in_buf);
+}
+
+void CachingMemoryReader::read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const
+{
+    prefetch_pages(beg, end);
+    for (auto itr = beg; itr != end; ++itr) {
+        read(itr->address, itr->destination, itr->length);
+    }
+}
+
+ReadStatus CachingMemoryReader::try_read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept
+{
+    if (copy_from_pages(addr, buf, bytes_in_buf)) return ReadStatus::ok;
+    return m_source->try_read(addr, buf, bytes_in_buf);
+}
+
+ReadStatus CachingMemoryReader::try_read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const noexcept
+{
+    prefetch_pages(beg, end);
+    for (auto itr = beg; itr != end; ++itr) {
+        auto status = try_read(itr->address, itr->destination, itr->length);
+        if (status != ReadStatus::ok) return status;
+    }
+    return ReadStatus::ok;
+}
+
+void CachingMemoryReader::invalidate() const {
+    if (++m_generation == k_no_generation) {
+        // wrapped around, old tags could collide with new generations
+        m_pages.clear();
+        m_generation = 0;
+    }
+}
+
+/* private */ CachingMemoryReader::Page * CachingMemoryReader::get_page_entry
+    (Address page_addr) const noexcept
+{
+    auto itr = m_pages.find(page_addr);
+    if (itr != m_pages.end()) return itr->second.get();
+
+    if (m_pages.size() >= k_max_pages) {
+        auto stale = std::find_if(m_pages.begin(), m_pages.end(),
+            [this](const auto & pair) { return !is_current(*pair.second); });
+        if (stale == m_pages.end()) return nullptr;
+        // rekeyed in place, so taking it over allocates nothing
+        auto node = m_pages.extract(stale);
+        node.key() = page_addr;
+        node.mapped()->generation = k_no_generation;
+        return m_pages.insert(std::move(node)).position->second.get();
+    }
+    try {
+        return m_pages.emplace(page_addr, std::make_unique<Page>()).first->second.get();
+    } catch (std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+/* private */ void CachingMemoryReader::prefetch_pages
+    (const ReadRequest * beg, const ReadRequest * end) const noexcept
+{
+    auto & missing       = m_missing;
+    auto & page_requests = m_page_requests;
+    missing      .clear();
+    page_requests.clear();
+    try {
+        for (auto itr = beg; itr != end; ++itr) {
+            if (itr->length == 0) continue;
+            auto last = page_of(itr->address + itr->length - 1);
+            for (auto page_addr = page_of(itr->address); ; page_addr += k_page_size) {
+                auto * page = get_page_entry(page_addr);
+                // pages that can't be cached are left to each read
+                if (page && !is_current(*page)) {
+                    missing.push_back(page);
+                    page_requests.push_back(ReadRequest { page_addr, page->bytes.data(), k_page_size });
+                    page->generation = m_generation;
+                    page->readable   = true;
+                }
+                if (page_addr == last) break;
+            }
+        }
+    } catch (std::bad_alloc &) {
+        // pages already marked as read must not be left unread
+        for (auto * page : missing) page->generation = k_no_generation;
+        return;
+    }
+    if (page_requests.empty()) return;
+    if (m_source->try_read_batch(page_requests) == ReadStatus::ok) return;
+
+    // find out which page(s) spoiled the batch
+    for (std::size_t i = 0; i != missing.size(); ++i) {
+        const auto & req = page_requests[i];
+        auto status = m_source->try_read(req.address, req.destination, req.length);
+        missing[i]->readable = (status == ReadStatus::ok);
+        if (is_fatal(status)) {
+            // leave it to a direct read of the source to report
+            missing[i]->generation = k_no_generation;
+        }
+    }
+}
+
+/* private */ const CachingMemoryReader::Page * CachingMemoryReader::fetch_page
+    (Address page_addr) const noexcept
+{
+    auto * page = get_page_entry(page_addr);
+    if (!page) return nullptr;
+    if (!is_current(*page)) {
+        auto status = m_source->try_read(page_addr, page->bytes.data(), k_page_size);
+        page->readable   = (status == ReadStatus::ok);
+        page->generation = is_fatal(status) ? k_no_generation : m_generation;
+    }
+    return page->readable ? page : nullptr;
+}
+
+/* private */ bool CachingMemoryReader::copy_from_pages
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept
+{
+    if (bytes_in_buf == 0) return true;
+    // make sure the whole request can be served before copying anything
+    auto first = page_of(addr);
+    auto last  = page_of(addr + bytes_in_buf - 1);
+    for (auto page_addr = first; ; page_addr += k_page_size) {
+        if (!fetch_page(page_addr)) return false;
+        if (page_addr == last) break;
+    }
+
+    auto * out = buf;
+    for (auto page_addr = first; ; page_addr += k_page_size) {
+        const auto & page = *m_pages.find(page_addr)->second;
+        auto beg = std::max(addr, page_addr) - page_addr;
+        auto end = std::min(addr + bytes_in_buf, page_addr + k_page_size) - page_addr;
+        out = std::copy(page.bytes.begin() + beg, page.bytes.begin() + end, out);
+        if (page_addr == last) break;
+    }
+    assert(out == buf + bytes_in_buf);
+    return true;
+}
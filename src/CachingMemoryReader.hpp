@@ -0,0 +1,116 @@
+/****************************************************************************
+
+    File: CachingMemoryReader.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "MemoryReader.hpp"
+
+#include <unordered_map>
+#include <array>
+
+/** Wraps any other reader, the first time a page of the target is touched it
+ *  is pulled in whole, all later reads on that page are served locally until
+ *  the cache is invalidated.
+ *
+ *  Pages are tagged with the generation they were read in, invalidating just
+ *  moves to the next generation (so page storage is reused tick to tick).
+ *  Reads which cannot be served from whole pages (say near the end of a
+ *  mapping, or a source that isn't page based) go straight to the source.
+ *
+ *  Not thread safe, meant to live on whatever thread does the decoding.
+ */
+class CachingMemoryReader final : public MemoryReader {
+public:
+    static constexpr const std::size_t k_page_size = 4096;
+
+    explicit CachingMemoryReader(std::shared_ptr<const MemoryReader>);
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    using MemoryReader::read_batch;
+    void read_batch(const ReadRequest * beg, const ReadRequest * end) const override;
+
+    ReadStatus try_read(Address, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override;
+
+    using MemoryReader::try_read_batch;
+    ReadStatus try_read_batch(const ReadRequest * beg, const ReadRequest * end) const noexcept override;
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return m_source->is_readable(addr, length); }
+
+    void describe_source(std::ostream & out) const override
+        { m_source->describe_source(out); }
+
+    /** All pages read before this call become stale (expected once per tick).
+     *  The cache is a detail of how reads are served, so this is still
+     *  considered a const operation.
+     */
+    void invalidate() const;
+
+    unsigned generation() const noexcept { return m_generation; }
+
+    const MemoryReader & source() const { return *m_source; }
+
+    std::shared_ptr<const MemoryReader> source_pointer() const { return m_source; }
+
+private:
+    // keeps memory bounded should items wander all over the heap, once full
+    // stale pages are taken over, and if there are none reads go straight to
+    // the source
+    static constexpr const std::size_t k_max_pages = 256;
+    static constexpr const unsigned    k_no_generation = unsigned(-1);
+
+    struct Page {
+        unsigned generation = k_no_generation;
+        bool     readable   = false;
+        std::array<uint8_t, k_page_size> bytes;
+    };
+
+    static Address page_of(Address addr) noexcept
+        { return addr & ~Address(k_page_size - 1); }
+
+    /** @returns the page's entry, or nullptr if the cache is full of pages
+     *           read this generation (or there is no memory for another)
+     */
+    Page * get_page_entry(Address page_addr) const noexcept;
+
+    /** Reads in every page needed by [beg end) which hasn't been read this
+     *  generation, all in one batch. Only an optimization, so it gives up
+     *  quietly if memory for it cannot be had.
+     */
+    void prefetch_pages(const ReadRequest * beg, const ReadRequest * end) const noexcept;
+
+    bool is_current(const Page & page) const noexcept
+        { return page.generation == m_generation; }
+
+    /** @returns nullptr if the page is not readable, or cannot be cached */
+    const Page * fetch_page(Address page_addr) const noexcept;
+
+    bool copy_from_pages(Address, uint8_t * buf, std::size_t) const noexcept;
+
+    std::shared_ptr<const MemoryReader> m_source;
+    mutable std::unordered_map<Address, std::unique_ptr<Page>> m_pages;
+    mutable unsigned m_generation = 0;
+    // prefetch_pages only, kept so that prefetching allocates nothing once
+    // warmed up
+    mutable std::vector<Page *> m_missing;
+    mutable ReadRequestList m_page_requests;
+};
@@ -0,0 +1,481 @@
+/****************************************************************************
+
+    File: CaptureFile.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include "CaptureFile.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <cmath>
+
+namespace {
+
+using Error = std::runtime_error;
+
+// literal runs only end at a run of unchanged bytes at least this long,
+// shorter ones cost more to break out of than to copy
+static constexpr const std::size_t k_min_unchanged_run = 4;
+
+template <typename T>
+void write_pod(std::ostream & out, const T & obj)
+    { out.write(reinterpret_cast<const char *>(&obj), sizeof(T)); }
+
+void put_varint(std::vector<uint8_t> & out, std::size_t x);
+
+void xor_rle_encode
+    (const std::vector<uint8_t> & previous, const std::vector<uint8_t> & current,
+     std::vector<uint8_t> & out);
+
+/** Reads values out of a range of the file, with bounds checks. */
+class ByteCursor {
+public:
+    ByteCursor(const uint8_t * beg, const uint8_t * end): m_itr(beg), m_end(end) {}
+
+    template <typename T>
+    bool get(T & obj) noexcept {
+        if (std::size_t(m_end - m_itr) < sizeof(T)) return false;
+        std::memcpy(&obj, m_itr, sizeof(T));
+        m_itr += sizeof(T);
+        return true;
+    }
+
+    bool get_varint(std::size_t &) noexcept;
+
+    /** @returns pointer to the next n bytes (skipping past them), nullptr if
+     *           there aren't enough
+     */
+    const uint8_t * take(std::size_t n) noexcept {
+        if (std::size_t(m_end - m_itr) < n) return nullptr;
+        auto rv = m_itr;
+        m_itr += n;
+        return rv;
+    }
+
+    const uint8_t * position() const noexcept { return m_itr; }
+
+private:
+    const uint8_t * m_itr;
+    const uint8_t * m_end;
+};
+
+/** @returns false if the payload is malformed */
+bool xor_rle_decode(const uint8_t * payload, std::size_t size, std::vector<uint8_t> & bytes);
+
+template <typename RegionType>
+const RegionType * find_region(const std::vector<RegionType> & regions, Address addr) {
+    auto itr = std::lower_bound(regions.begin(), regions.end(), addr,
+        [](const RegionType & region, Address addr)
+        { return region.region.address < addr; });
+    if (itr == regions.end() || itr->region.address != addr) return nullptr;
+    return &*itr;
+}
+
+} // end of <anonymous> namespace
+
+CaptureWriter::CaptureWriter(const std::string & filename, double keyframe_interval):
+    m_filename(filename),
+    m_out(filename, std::ios::binary | std::ios::trunc),
+    m_keyframe_interval(keyframe_interval),
+    m_start(Clock::now())
+{
+    using namespace CaptureFormat;
+    if (!m_out) {
+        throw Error("CaptureWriter: cannot open \"" + filename + "\" for writing.");
+    }
+    Header header {};
+    std::copy(k_magic, k_magic + k_magic_size, header.magic);
+    header.version = k_version;
+    write_pod(m_out, header);
+}
+
+CaptureWriter::~CaptureWriter() {
+    try {
+        finish();
+    } catch (...) {
+        // the capture is still readable without its index
+    }
+}
+
+void CaptureWriter::add_frame(const MemoryReader & memory, MemoryRegionList regions) {
+    using namespace CaptureFormat;
+    if (m_finished) {
+        throw std::runtime_error("CaptureWriter::add_frame: capture is already finished.");
+    }
+    merge_regions(regions);
+
+    // storage is reused frame to frame
+    m_current.resize(regions.size());
+    ReadRequestList requests;
+    requests.reserve(regions.size());
+    for (std::size_t i = 0; i != regions.size(); ++i) {
+        m_current[i].region = regions[i];
+        m_current[i].bytes.resize(regions[i].length);
+        requests.push_back(ReadRequest { regions[i].address, m_current[i].bytes.data(), regions[i].length });
+    }
+    auto check = [](ReadStatus status) {
+        if (status == ReadStatus::no_permission) {
+            throw PermissionError("Lost permission to read the target's memory.");
+        } else if (is_fatal(status)) {
+            throw Error("CaptureWriter::add_frame: target process is no longer readable.");
+        }
+        return status == ReadStatus::ok;
+    };
+    if (!check(memory.try_read_batch(requests))) {
+        for (std::size_t i = 0; i != requests.size(); ++i) {
+            const auto & req = requests[i];
+            if (!check(memory.try_read(req.address, req.destination, req.length))) {
+                m_current[i].region.length = 0;
+            }
+        }
+        m_current.erase(std::remove_if(m_current.begin(), m_current.end(),
+            [](const Region & region) { return region.region.length == 0; }),
+            m_current.end());
+    }
+
+    double timestamp = std::chrono::duration<double>(Clock::now() - m_start).count();
+    bool keyframe = m_frame_count == 0 || timestamp - m_last_keyframe >= m_keyframe_interval;
+    if (keyframe) {
+        m_index.push_back(IndexEntry { timestamp, uint64_t(m_out.tellp()) });
+        m_last_keyframe = timestamp;
+    }
+    write_pod(m_out, uint8_t(keyframe ? k_keyframe : k_delta_frame));
+    write_pod(m_out, timestamp);
+    write_pod(m_out, uint32_t(m_current.size()));
+    for (const auto & region : m_current) {
+        const auto * previous = keyframe ? nullptr : find_region(m_previous, region.region.address);
+        bool as_delta = previous && previous->region.length == region.region.length;
+        const auto * payload = region.bytes.data();
+        std::size_t payload_size = region.bytes.size();
+        if (as_delta) {
+            m_payload.clear();
+            xor_rle_encode(previous->bytes, region.bytes, m_payload);
+            payload      = m_payload.data();
+            payload_size = m_payload.size();
+        }
+        write_pod(m_out, uint64_t(region.region.address));
+        write_pod(m_out, uint32_t(region.region.length));
+        write_pod(m_out, uint8_t(as_delta ? k_xor_rle : k_raw));
+        write_pod(m_out, uint32_t(payload_size));
+        m_out.write(reinterpret_cast<const char *>(payload), std::streamsize(payload_size));
+    }
+    if (!m_out) {
+        throw Error("CaptureWriter::add_frame: failed while writing \"" + m_filename + "\".");
+    }
+    m_previous.swap(m_current);
+    ++m_frame_count;
+}
+
+void CaptureWriter::finish() {
+    using namespace CaptureFormat;
+    if (m_finished) return;
+    m_finished = true;
+
+    Footer footer {};
+    footer.index_offset   = uint64_t(m_out.tellp());
+    footer.keyframe_count = m_index.size();
+    std::copy(k_index_magic, k_index_magic + k_magic_size, footer.magic);
+    for (const auto & entry : m_index) write_pod(m_out, entry);
+    write_pod(m_out, footer);
+    m_out.flush();
+    if (!m_out) {
+        throw Error("CaptureWriter::finish: failed while writing \"" + m_filename + "\".");
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+CaptureReader::CaptureReader(const std::string & filename):
+    m_filename(filename)
+{
+    using namespace CaptureFormat;
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw Error("CaptureReader: cannot open \"" + filename + "\".");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(Header)) {
+        (void)close(fd);
+        throw Error("CaptureReader: \"" + filename + "\" is too small to be a capture.");
+    }
+    m_map_size = std::size_t(st.st_size);
+    void * map = mmap(nullptr, m_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping stays valid once the descriptor is closed
+    (void)close(fd);
+    if (map == MAP_FAILED) {
+        throw Error("CaptureReader: cannot map \"" + filename + "\".");
+    }
+    m_map = static_cast<const uint8_t *>(map);
+
+    auto fail = [this](const char * why) {
+        (void)munmap(const_cast<uint8_t *>(m_map), m_map_size);
+        throw Error(std::string("CaptureReader: \"") + m_filename + "\" " + why);
+    };
+
+    Header header;
+    std::memcpy(&header, m_map, sizeof(Header));
+    if (!std::equal(header.magic, header.magic + k_magic_size, k_magic)) {
+        fail("is not a capture file.");
+    }
+    if (header.version != k_version) {
+        fail("has an unsupported version.");
+    }
+
+    // trust the index only if the footer is intact
+    Footer footer {};
+    bool has_footer = m_map_size >= sizeof(Header) + sizeof(Footer);
+    if (has_footer) {
+        std::memcpy(&footer, m_map + m_map_size - sizeof(Footer), sizeof(Footer));
+        auto index_end = footer.index_offset + footer.keyframe_count*sizeof(IndexEntry);
+        has_footer =    std::equal(footer.magic, footer.magic + k_magic_size, k_index_magic)
+                     && footer.index_offset >= sizeof(Header)
+                     && footer.keyframe_count <= m_map_size / sizeof(IndexEntry)
+                     && index_end == m_map_size - sizeof(Footer);
+    }
+    if (has_footer) {
+        m_frames_end = footer.index_offset;
+        m_index.resize(footer.keyframe_count);
+        std::memcpy(m_index.data(), m_map + footer.index_offset,
+                    footer.keyframe_count*sizeof(IndexEntry));
+    } else {
+        rebuild_index();
+    }
+    seek(0.);
+}
+
+CaptureReader::~CaptureReader()
+    { (void)munmap(const_cast<uint8_t *>(m_map), m_map_size); }
+
+void CaptureReader::read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const
+{
+    const auto * src = find(addr, bytes_in_buf);
+    if (!src) {
+        throw Error("CaptureReader::read: address " + std::to_string(addr)
+                    + " was not captured in the current frame.");
+    }
+    std::copy_n(src, bytes_in_buf, buf);
+}
+
+void CaptureReader::describe_source(std::ostream & out) const
+    { out << "capture \"" << m_filename << "\" at " << m_timestamp << " seconds"; }
+
+void CaptureReader::seek(double seconds) {
+    if (m_index.empty()) return;
+    auto itr = std::upper_bound(m_index.begin(), m_index.end(), seconds,
+        [](double t, const CaptureFormat::IndexEntry & entry)
+        { return t < entry.timestamp; });
+    if (itr != m_index.begin()) --itr;
+    if (!decode_frame_at(itr->offset)) return;
+
+    // deltas up to (not past) the time asked for
+    while (m_next_offset < m_frames_end) {
+        ByteCursor cursor(m_map + m_next_offset, m_map + m_frames_end);
+        uint8_t kind;
+        double timestamp;
+        if (!cursor.get(kind) || !cursor.get(timestamp) || timestamp > seconds) break;
+        if (!next_frame()) break;
+    }
+}
+
+bool CaptureReader::next_frame()
+    { return decode_frame_at(m_next_offset); }
+
+std::size_t CaptureReader::frame_bytes() const noexcept {
+    std::size_t rv = 0;
+    for (const auto & region : m_regions) rv += region.region.length;
+    return rv;
+}
+
+/* private */ bool CaptureReader::decode_frame_at(uint64_t offset) {
+    using namespace CaptureFormat;
+    if (offset >= m_frames_end) return false;
+    ByteCursor cursor(m_map + offset, m_map + m_frames_end);
+    uint8_t  kind;
+    double   timestamp;
+    uint32_t count;
+    if (!cursor.get(kind) || !cursor.get(timestamp) || !cursor.get(count)) return false;
+
+    m_decoding.resize(count);
+    for (auto & region : m_decoding) {
+        uint64_t address;
+        uint32_t length, payload_size;
+        uint8_t  encoding;
+        if (   !cursor.get(address) || !cursor.get(length) || !cursor.get(encoding)
+            || !cursor.get(payload_size))
+        { return false; }
+        const auto * payload = cursor.take(payload_size);
+        if (!payload) return false;
+
+        region.region = MemoryRegion { Address(address), length };
+        if (encoding == k_raw) {
+            if (payload_size != length) return false;
+            region.bytes.assign(payload, payload + payload_size);
+            continue;
+        }
+        const auto * previous = find_region(m_regions, region.region.address);
+        if (   encoding != k_xor_rle || kind == k_keyframe || !previous
+            || previous->region.length != region.region.length)
+        { return false; }
+        region.bytes = previous->bytes;
+        if (!xor_rle_decode(payload, payload_size, region.bytes)) return false;
+    }
+    m_regions.swap(m_decoding);
+    m_frame_regions.clear();
+    for (const auto & region : m_regions) m_frame_regions.push_back(region.region);
+    m_timestamp   = timestamp;
+    m_next_offset = uint64_t(cursor.position() - m_map);
+    return true;
+}
+
+/* private */ void CaptureReader::rebuild_index() {
+    using namespace CaptureFormat;
+    // walk frame headers, skipping payloads, up to the last whole frame
+    m_index.clear();
+    uint64_t offset = sizeof(Header);
+    m_frames_end = offset;
+    ByteCursor cursor(m_map + offset, m_map + m_map_size);
+    double last_timestamp = 0.;
+    while (true) {
+        uint8_t  kind;
+        double   timestamp;
+        uint32_t count;
+        if (!cursor.get(kind) || !cursor.get(timestamp) || !cursor.get(count)) return;
+        // a partly written index looks a lot like garbage frames
+        if (   kind > k_delta_frame || !std::isfinite(timestamp) || timestamp < last_timestamp
+            || (m_index.empty() && kind != k_keyframe))
+        { return; }
+        last_timestamp = timestamp;
+        for (uint32_t i = 0; i != count; ++i) {
+            uint64_t address;
+            uint32_t length, payload_size;
+            uint8_t  encoding;
+            if (   !cursor.get(address) || !cursor.get(length) || !cursor.get(encoding)
+                || !cursor.get(payload_size) || !cursor.take(payload_size))
+            { return; }
+        }
+        if (kind == k_keyframe) m_index.push_back(IndexEntry { timestamp, offset });
+        offset = m_frames_end = uint64_t(cursor.position() - m_map);
+    }
+}
+
+/* private */ const uint8_t * CaptureReader::find
+    (Address addr, std::size_t length) const noexcept
+{
+    auto idx = find_in_regions(m_frame_regions, addr, length);
+    if (idx == k_no_region) return nullptr;
+    return m_regions[idx].bytes.data() + (addr - m_frame_regions[idx].address);
+}
+
+// ----------------------------------------------------------------------------
+
+CaptureStats measure_capture(const std::string & filename) {
+    using Clock = std::chrono::steady_clock;
+    CaptureReader reader(filename);
+    CaptureStats stats;
+    stats.file_bytes     = reader.file_size();
+    stats.keyframe_count = reader.keyframe_count();
+    if (reader.keyframe_count() == 0) return stats;
+
+    auto start = Clock::now();
+    // the constructor already decoded the first frame, count it all the same
+    reader.seek(-1.);
+    do {
+        stats.raw_bytes += reader.frame_bytes();
+        ++stats.frame_count;
+    } while (reader.next_frame());
+    stats.decode_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+namespace {
+
+void put_varint(std::vector<uint8_t> & out, std::size_t x) {
+    for (; x >= 0x80; x >>= 7) {
+        out.push_back(uint8_t(x & 0x7F) | 0x80);
+    }
+    out.push_back(uint8_t(x));
+}
+
+void xor_rle_encode
+    (const std::vector<uint8_t> & previous, const std::vector<uint8_t> & current,
+     std::vector<uint8_t> & out)
+{
+    const auto n = current.size();
+    std::size_t i = 0;
+    while (i < n) {
+        auto unchanged_begin = i;
+        while (i < n && previous[i] == current[i]) ++i;
+        put_varint(out, i - unchanged_begin);
+        if (i == n) break;
+
+        auto literal_begin = i;
+        while (i < n) {
+            if (previous[i] != current[i]) {
+                ++i;
+                continue;
+            }
+            auto j = i;
+            while (j < n && previous[j] == current[j]) ++j;
+            if (j == n || j - i >= k_min_unchanged_run) break;
+            i = j;
+        }
+        put_varint(out, i - literal_begin);
+        for (auto k = literal_begin; k != i; ++k) {
+            out.push_back(previous[k] ^ current[k]);
+        }
+    }
+}
+
+bool ByteCursor::get_varint(std::size_t & x) noexcept {
+    x = 0;
+    for (int shift = 0; shift < int(sizeof(std::size_t)*8); shift += 7) {
+        uint8_t byte;
+        if (!get(byte)) return false;
+        x |= std::size_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool xor_rle_decode(const uint8_t * payload, std::size_t size, std::vector<uint8_t> & bytes) {
+    ByteCursor cursor(payload, payload + size);
+    const auto n = bytes.size();
+    std::size_t i = 0;
+    while (i < n) {
+        std::size_t unchanged, literal;
+        if (!cursor.get_varint(unchanged) || unchanged > n - i) return false;
+        i += unchanged;
+        if (i == n) break;
+        if (!cursor.get_varint(literal) || literal > n - i) return false;
+        const auto * xors = cursor.take(literal);
+        if (!xors) return false;
+        for (std::size_t k = 0; k != literal; ++k) bytes[i + k] ^= xors[k];
+        i += literal;
+    }
+    return true;
+}
+
+} // end of <anonymous> namespace
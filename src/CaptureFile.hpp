@@ -0,0 +1,215 @@
+/****************************************************************************
+
+    File: CaptureFile.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include "MemoryReader.hpp"
+
+#include <chrono>
+#include <fstream>
+
+/** Captures follow watched regions over long sessions: every so often a
+ *  keyframe holds each region whole, every other frame only holds the
+ *  regions XORed with the frame before, run length encoded (so unchanged
+ *  bytes cost next to nothing).
+ *
+ *  Layout (all integers in the writing machine's byte order):
+ *  - header: 8 byte magic "APIRCAPT", u32 version, u32 reserved
+ *  - frames: u8 kind, f64 timestamp, u32 region count, then per region:
+ *    u64 address, u32 length, u8 encoding, u32 payload size, payload
+ *  - keyframe index: per keyframe f64 timestamp, u64 file offset
+ *  - footer: u64 index offset, u64 keyframe count, 8 byte magic "APIRCIDX"
+ *
+ *  XOR/RLE payloads alternate varint run lengths: zero bytes to skip, then
+ *  literal bytes to XOR in (followed by the bytes), until the region is
+ *  covered. A capture cut short (no footer) is still readable, the index is
+ *  rebuilt by walking the frames.
+ */
+namespace CaptureFormat {
+
+constexpr const char     k_magic[]       = "APIRCAPT";
+constexpr const char     k_index_magic[] = "APIRCIDX";
+constexpr const int      k_magic_size    = 8;
+constexpr const uint32_t k_version       = 1;
+
+enum FrameKind : uint8_t { k_keyframe, k_delta_frame };
+enum Encoding  : uint8_t { k_raw, k_xor_rle };
+
+struct Header {
+    char     magic[k_magic_size];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct IndexEntry {
+    double   timestamp;
+    uint64_t offset;
+};
+
+struct Footer {
+    uint64_t index_offset;
+    uint64_t keyframe_count;
+    char     magic[k_magic_size];
+};
+
+} // end of CaptureFormat namespace
+
+/** Writes frames of the watched regions to a capture file, a keyframe at
+ *  least every keyframe interval (in seconds), deltas otherwise.
+ */
+class CaptureWriter {
+public:
+    static constexpr const double k_default_keyframe_interval = 60.;
+
+    explicit CaptureWriter(const std::string & filename,
+                           double keyframe_interval = k_default_keyframe_interval);
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter & operator = (const CaptureWriter &) = delete;
+
+    /** Finishes the file, if not done already. */
+    ~CaptureWriter();
+
+    /** Reads the regions (merged first) and writes them as a frame, stamped
+     *  with the time since the writer was made. Unreadable regions are left
+     *  out of the frame.
+     *  @throws if the file cannot be written, or on fatal read errors
+     */
+    void add_frame(const MemoryReader &, MemoryRegionList regions);
+
+    /** Writes the keyframe index and footer, no frames may follow. */
+    void finish();
+
+    std::size_t frame_count() const noexcept { return m_frame_count; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Region {
+        MemoryRegion region;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::string m_filename;
+    std::ofstream m_out;
+    double m_keyframe_interval;
+    Clock::time_point m_start;
+    double m_last_keyframe = 0.;
+    std::size_t m_frame_count = 0;
+    bool m_finished = false;
+
+    std::vector<CaptureFormat::IndexEntry> m_index;
+    // last frame's regions, sorted by address
+    std::vector<Region> m_previous;
+    std::vector<Region> m_current;
+    std::vector<uint8_t> m_payload;
+};
+
+/** Plays back a capture, serving reads from the frame it's currently on.
+ *  Seeking decodes exactly one keyframe and the deltas after it.
+ *  Not thread safe.
+ */
+class CaptureReader final : public MemoryReader {
+public:
+    explicit CaptureReader(const std::string & filename);
+
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader & operator = (const CaptureReader &) = delete;
+
+    ~CaptureReader() override;
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return find(addr, length) != nullptr; }
+
+    void describe_source(std::ostream &) const override;
+
+    /** Moves to the last frame at or before the given time (or the first
+     *  frame, if it's earlier than all of them).
+     */
+    void seek(double seconds);
+
+    /** Moves to the next frame.
+     *  @returns false if already on the last frame
+     */
+    bool next_frame();
+
+    /** @returns timestamp of the current frame */
+    double timestamp() const noexcept { return m_timestamp; }
+
+    /** @returns timestamp of the last keyframe in the index */
+    double last_keyframe_time() const noexcept
+        { return m_index.empty() ? 0. : m_index.back().timestamp; }
+
+    std::size_t keyframe_count() const noexcept { return m_index.size(); }
+
+    /** @returns total bytes of the current frame's regions */
+    std::size_t frame_bytes() const noexcept;
+
+    std::size_t file_size() const noexcept { return m_map_size; }
+
+private:
+    struct Region {
+        MemoryRegion region;
+        std::vector<uint8_t> bytes;
+    };
+
+    /** @returns false if there are no more frames */
+    bool decode_frame_at(uint64_t offset);
+    void rebuild_index();
+
+    const uint8_t * find(Address, std::size_t) const noexcept;
+
+    std::string m_filename;
+    const uint8_t * m_map = nullptr;
+    std::size_t m_map_size = 0;
+    uint64_t m_frames_end = 0;
+    std::vector<CaptureFormat::IndexEntry> m_index;
+
+    uint64_t m_next_offset = 0;
+    double m_timestamp = 0.;
+    std::vector<Region> m_regions;
+    std::vector<Region> m_decoding;
+    // m_regions' spans alone, for find_in_regions
+    MemoryRegionList m_frame_regions;
+};
+
+struct CaptureStats {
+    std::size_t frame_count    = 0;
+    std::size_t keyframe_count = 0;
+    // what the frames would take as full dumps
+    std::size_t raw_bytes      = 0;
+    std::size_t file_bytes     = 0;
+    double      decode_seconds = 0.;
+
+    double compression_ratio() const noexcept
+        { return file_bytes ? double(raw_bytes) / double(file_bytes) : 0.; }
+
+    double decode_megabytes_per_second() const noexcept
+        { return decode_seconds > 0. ? double(raw_bytes) / (decode_seconds*1e6) : 0.; }
+};
+
+/** Decodes every frame of a capture, for reporting its compression ratio and
+ *  decode throughput.
+ */
+CaptureStats measure_capture(const std::string & filename);
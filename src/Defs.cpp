@@ -20,18 +20,63 @@
 *****************************************************************************/
 
 #include "Defs.hpp"
+#include "ReadProfile.hpp"
 
 #include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <ncurses.h>
 
+#include <atomic>
+#include <array>
+#include <algorithm>
+#include <chrono>
+
 #include <cassert>
+#include <cerrno>
+#include <climits>
 
 namespace {
 
+#ifdef IOV_MAX
+constexpr const std::size_t k_iov_max = IOV_MAX;
+#else
+constexpr const std::size_t k_iov_max = 1024;
+#endif
+
+std::atomic<std::size_t> s_read_syscall_count { 0 };
+
 template <typename T>
 void rev(uint8_t *);
 
+[[noreturn]] void throw_read_error(int pid, int err);
+
+[[noreturn]] void throw_file_read_error(int fd, int err);
+
+// these do the actual reading, returning zero or an errno value
+
+int vm_read(int pid, Address, uint8_t * buffer, std::size_t buffer_len) noexcept;
+
+int vm_read(int pid, const ReadRequest * beg, const ReadRequest * end) noexcept;
+
+int file_read(int fd, Address, uint8_t * buffer, std::size_t buffer_len) noexcept;
+
+/** Counts a read syscall, and if reads are profiled, times it and
+ *  attributes it to the calling thread's read site.
+ *  @returns whatever the syscall does
+ */
+template <typename Func>
+ssize_t counted_read_syscall(std::size_t expected, Func && f) noexcept;
+
+int file_read(int fd, const ReadRequest * beg, const ReadRequest * end) noexcept;
+
+/** Maps a short read from the memory file to an errno value. Once the
+ *  target exits its memory file reads nothing at all, so an empty result
+ *  for a non-empty request is ESRCH, like process_vm_readv reports it.
+ */
+int short_file_read_error(ssize_t res) noexcept;
+
 } // end of <anonymous> namespace
 
 Event to_event(int key) {
@@ -54,6 +99,79 @@ Event to_event(int key) {
     }
 }
 
+void merge_regions(MemoryRegionList & regions) {
+    regions.erase(
+        std::remove_if(regions.begin(), regions.end(),
+                       [](const MemoryRegion & r) { return r.length == 0; }),
+        regions.end());
+    if (regions.empty()) return;
+    std::sort(regions.begin(), regions.end(),
+        [](const MemoryRegion & lhs, const MemoryRegion & rhs)
+        { return lhs.address < rhs.address; });
+    auto last = regions.begin();
+    for (auto itr = regions.begin() + 1; itr != regions.end(); ++itr) {
+        if (itr->address <= last->end()) {
+            last->length = std::max(last->end(), itr->end()) - last->address;
+        } else {
+            *++last = *itr;
+        }
+    }
+    regions.erase(last + 1, regions.end());
+}
+
+std::size_t find_in_regions
+    (const MemoryRegionList & regions, Address addr, std::size_t length) noexcept
+{
+    // first region starting after addr, the one before it is the candidate
+    auto itr = std::upper_bound(regions.begin(), regions.end(), addr,
+        [](Address addr, const MemoryRegion & region)
+        { return addr < region.address; });
+    if (itr == regions.begin()) return k_no_region;
+    --itr;
+    if (addr + length > itr->end()) return k_no_region;
+    return std::size_t(itr - regions.begin());
+}
+
+uint64_t hash_bytes(const uint8_t * data, std::size_t length, uint64_t seed) noexcept {
+    // loosely following xxhash64's structure
+    static constexpr const uint64_t k_prime_1 = 0x9E3779B185EBCA87ull;
+    static constexpr const uint64_t k_prime_2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr const uint64_t k_prime_3 = 0x165667B19E3779F9ull;
+    static constexpr const int      k_lanes   = 4;
+    auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+    auto load = [](const uint8_t * p) {
+        uint64_t rv;
+        std::memcpy(&rv, p, sizeof(uint64_t));
+        return rv;
+    };
+
+    std::array<uint64_t, k_lanes> acc = {
+        seed + k_prime_1 + k_prime_2, seed + k_prime_2, seed, seed - k_prime_1 };
+    const auto * itr = data;
+    const auto * end = data + length;
+    for (; end - itr >= k_lanes*8; itr += k_lanes*8) {
+        for (int i = 0; i != k_lanes; ++i) {
+            acc[i] = rotl(acc[i] + load(itr + i*8)*k_prime_2, 31)*k_prime_1;
+        }
+    }
+
+    uint64_t h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+    h += uint64_t(length);
+    for (; end - itr >= 8; itr += 8) {
+        h ^= rotl(load(itr)*k_prime_2, 31)*k_prime_1;
+        h  = rotl(h, 27)*k_prime_1 + k_prime_3;
+    }
+    for (; itr != end; ++itr) {
+        h ^= (*itr)*k_prime_3;
+        h  = rotl(h, 11)*k_prime_1;
+    }
+    h ^= h >> 33;
+    h *= k_prime_2;
+    h ^= h >> 29;
+    h *= k_prime_3;
+    return h ^ (h >> 32);
+}
+
 /* vtable anchor */ MemoryRecorder::~MemoryRecorder() {}
 
 void AddressRecorder::record(Address addr, const uint8_t *, std::size_t) {
@@ -74,33 +192,72 @@ void AddressRecorder::record(Address addr, const uint8_t *, std::size_t) {
 void read_memory_to
     (int pid, Address targets_addr, uint8_t * buffer, std::size_t buffer_len)
 {
+    if (int err = vm_read(pid, targets_addr, buffer, buffer_len)) {
+        throw_read_error(pid, err);
+    }
+}
+
+void read_memory_to(int pid, const ReadRequest * beg, const ReadRequest * end) {
+    if (int err = vm_read(pid, beg, end)) {
+        throw_read_error(pid, err);
+    }
+}
+
+ReadStatus try_read_memory_to
+    (int pid, Address targets_addr, uint8_t * buffer, std::size_t buffer_len) noexcept
+{ return to_read_status(vm_read(pid, targets_addr, buffer, buffer_len)); }
+
+ReadStatus try_read_memory_to
+    (int pid, const ReadRequest * beg, const ReadRequest * end) noexcept
+{ return to_read_status(vm_read(pid, beg, end)); }
+
+int open_process_memory(int pid) {
     using Error = std::runtime_error;
+    auto path = "/proc/" + std::to_string(pid) + "/mem";
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) return fd;
+    switch (errno) {
+    case EACCES: case EPERM: throw PermissionError(
+        "The caller does not have permission to open the memory file of the "
+        "process pid.");
+    case ENOENT: throw Error("No process with pid (" + std::to_string(pid) + ") exists.");
+    default: throw Error("Failed to open \"" + path + "\" (errno " + std::to_string(errno) + ").");
+    }
+}
 
-    struct iovec local;
-    struct iovec remote;
-    remote.iov_len  = local.iov_len = buffer_len;
-    local .iov_base = buffer;
-    remote.iov_base = reinterpret_cast<void *>(targets_addr);
-    if (std::size_t(process_vm_readv(pid, &local, 1, &remote, 1, 0)) != buffer_len) {
-        // error strings straight out of:
-        // https://man7.org/linux/man-pages/man2/process_vm_readv.2.html
-        switch (errno) {
-        case EINVAL: throw Error("Flags are not 0 or liovcnt or riovcnt is too large.");
-        case EFAULT: throw Error(
-            "The memory described by local_iov is outside the caller's "
-            "accessible address space. OR\n"
-            "The memory described by remote_iov is outside the accessible "
-            "address space of the process pid.");
-        case ENOMEM: throw Error(
-            "Could not allocate memory for internal copies of the iovec structures.");
-        case EPERM:  throw PermissionError(
-            "The caller does not have permission to access the address space "
-            "of the process pid.");
-        case ESRCH: throw Error("No process with pid (" + std::to_string(pid) + ") exists.");
-        };
+void read_memory_file_to
+    (int fd, Address targets_addr, uint8_t * buffer, std::size_t buffer_len)
+{
+    if (int err = file_read(fd, targets_addr, buffer, buffer_len)) {
+        throw_file_read_error(fd, err);
+    }
+}
+
+void read_memory_file_to(int fd, const ReadRequest * beg, const ReadRequest * end) {
+    if (int err = file_read(fd, beg, end)) {
+        throw_file_read_error(fd, err);
     }
 }
 
+ReadStatus try_read_memory_file_to
+    (int fd, Address targets_addr, uint8_t * buffer, std::size_t buffer_len) noexcept
+{ return to_read_status(file_read(fd, targets_addr, buffer, buffer_len)); }
+
+ReadStatus try_read_memory_file_to
+    (int fd, const ReadRequest * beg, const ReadRequest * end) noexcept
+{ return to_read_status(file_read(fd, beg, end)); }
+
+std::size_t read_memory_syscall_count() { return s_read_syscall_count; }
+
+ReadStatus to_read_status(int err) noexcept {
+    switch (err) {
+    case 0     : return ReadStatus::ok;
+    case EFAULT: case EIO: return ReadStatus::bad_address;
+    case ESRCH : return ReadStatus::no_process;
+    case EPERM : case EACCES: return ReadStatus::no_permission;
+    default    : return ReadStatus::failed;
+    }
+}
 
 decltype(k_big_endian) get_machine_endianness() {
     // lsb first == little endian
@@ -160,4 +317,139 @@ BigT revt(BigT a) {
     return (BigT(low) << sizeof(SmaT)*8) | high;
 }
 
+int vm_read
+    (int pid, Address targets_addr, uint8_t * buffer, std::size_t buffer_len) noexcept
+{
+    struct iovec local;
+    struct iovec remote;
+    remote.iov_len  = local.iov_len = buffer_len;
+    local .iov_base = buffer;
+    remote.iov_base = reinterpret_cast<void *>(targets_addr);
+    auto res = counted_read_syscall(buffer_len, [&]()
+        { return process_vm_readv(pid, &local, 1, &remote, 1, 0); });
+    if (res < 0) return errno;
+    // partial reads stop at the first remote iovec that could not be
+    // read, which is the same as EFAULT for our purposes
+    return std::size_t(res) == buffer_len ? 0 : EFAULT;
+}
+
+int vm_read(int pid, const ReadRequest * beg, const ReadRequest * end) noexcept {
+    std::array<struct iovec, k_iov_max> locals;
+    std::array<struct iovec, k_iov_max> remotes;
+    while (beg != end) {
+        std::size_t count    = 0;
+        std::size_t expected = 0;
+        for (; beg != end && count != k_iov_max; ++beg) {
+            if (beg->length == 0) continue;
+            locals [count].iov_base = beg->destination;
+            remotes[count].iov_base = reinterpret_cast<void *>(beg->address);
+            locals [count].iov_len  = remotes[count].iov_len = beg->length;
+            expected += beg->length;
+            ++count;
+        }
+        if (count == 0) return 0;
+
+        auto res = counted_read_syscall(expected, [&]()
+            { return process_vm_readv(pid, locals.data(), count, remotes.data(), count, 0); });
+        if (res < 0) return errno;
+        if (std::size_t(res) != expected) return EFAULT;
+    }
+    return 0;
+}
+
+int file_read
+    (int fd, Address targets_addr, uint8_t * buffer, std::size_t buffer_len) noexcept
+{
+    auto res = counted_read_syscall(buffer_len, [&]()
+        { return pread(fd, buffer, buffer_len, off_t(targets_addr)); });
+    if (res < 0) return errno;
+    return std::size_t(res) == buffer_len ? 0 : short_file_read_error(res);
+}
+
+int file_read(int fd, const ReadRequest * beg, const ReadRequest * end) noexcept {
+    std::array<struct iovec, k_iov_max> locals;
+    while (beg != end) {
+        if (beg->length == 0) {
+            ++beg;
+            continue;
+        }
+        // gather a run of requests that sit back to back in the target
+        auto run_start = beg->address;
+        auto next_addr = beg->address;
+        std::size_t count    = 0;
+        std::size_t expected = 0;
+        for (; beg != end && count != k_iov_max; ++beg) {
+            if (beg->length == 0) continue;
+            if (beg->address != next_addr) break;
+            locals[count].iov_base = beg->destination;
+            locals[count].iov_len  = beg->length;
+            next_addr += beg->length;
+            expected  += beg->length;
+            ++count;
+        }
+
+        auto res = counted_read_syscall(expected, [&]()
+            { return preadv(fd, locals.data(), int(count), off_t(run_start)); });
+        if (res < 0) return errno;
+        if (std::size_t(res) != expected) return short_file_read_error(res);
+    }
+    return 0;
+}
+
+int short_file_read_error(ssize_t res) noexcept
+    { return res == 0 ? ESRCH : EIO; }
+
+template <typename Func>
+ssize_t counted_read_syscall(std::size_t expected, Func && f) noexcept {
+    using namespace std::chrono;
+    ++s_read_syscall_count;
+    if (!is_read_profiling()) return f();
+
+    auto start = steady_clock::now();
+    auto res = f();
+    // errno must survive the clock and the bookkeeping
+    int err = errno;
+    auto ns = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+    ReadSite::current().record(res < 0 ? 0 : std::size_t(res), uint64_t(ns),
+                               res < 0 || std::size_t(res) != expected);
+    errno = err;
+    return res;
+}
+
+[[noreturn]] void throw_read_error(int pid, int err) {
+    using Error = std::runtime_error;
+    // error strings straight out of:
+    // https://man7.org/linux/man-pages/man2/process_vm_readv.2.html
+    switch (err) {
+    case EINVAL: throw Error("Flags are not 0 or liovcnt or riovcnt is too large.");
+    case EFAULT: throw Error(
+        "The memory described by local_iov is outside the caller's "
+        "accessible address space. OR\n"
+        "The memory described by remote_iov is outside the accessible "
+        "address space of the process pid.");
+    case ENOMEM: throw Error(
+        "Could not allocate memory for internal copies of the iovec structures.");
+    case EPERM:  throw PermissionError(
+        "The caller does not have permission to access the address space "
+        "of the process pid.");
+    case ESRCH: throw Error("No process with pid (" + std::to_string(pid) + ") exists.");
+    default: throw Error("process_vm_readv failed (errno " + std::to_string(err) + ").");
+    };
+}
+
+[[noreturn]] void throw_file_read_error(int fd, int err) {
+    using Error = std::runtime_error;
+    switch (err) {
+    // unmapped addresses show up as EIO on the memory file
+    case EIO: case EFAULT: throw Error(
+        "The memory described is outside the accessible address space of the "
+        "process (/proc/pid/mem).");
+    case EACCES: case EPERM: throw PermissionError(
+        "The caller does not have permission to read the memory file of the "
+        "process.");
+    case ESRCH: throw Error("Process behind descriptor (" + std::to_string(fd) + ") no longer exists.");
+    default: throw Error("pread on process memory failed (errno " + std::to_string(err) + ").");
+    }
+}
+
 } // end of <anonymous> namespace
@@ -25,6 +25,7 @@
 #include <cstring>
 
 #include <string>
+#include <vector>
 
 #include <common/StringUtil.hpp>
 #include <common/MultiType.hpp>
@@ -51,6 +52,45 @@ constexpr const Address k_no_address   =  0;
 
 // ------------------------------ low level stuff -----------------------------
 
+/** A contiguous span of the target's address space. */
+struct MemoryRegion {
+    Address     address = k_no_address;
+    std::size_t length  = 0;
+
+    Address end() const noexcept { return address + length; }
+};
+
+using MemoryRegionList = std::vector<MemoryRegion>;
+
+constexpr const std::size_t k_no_region = std::size_t(-1);
+
+/** A local copy of a contiguous span of the target's address space, the
+ *  bytes belong to whoever made the copy.
+ */
+struct ByteSpan {
+    Address         address = k_no_address;
+    const uint8_t * data    = nullptr;
+    std::size_t     size    = 0;
+
+    bool contains(Address addr, std::size_t length) const noexcept
+        { return addr >= address && addr - address + length <= size; }
+};
+
+/** Sorts regions and merges any that overlap or touch. */
+void merge_regions(MemoryRegionList &);
+
+/** @param regions sorted, and not overlapping (as merge_regions leaves them)
+ *  @returns index of the region holding all of [addr, addr + length), or
+ *           k_no_region if no one region does
+ */
+std::size_t find_in_regions(const MemoryRegionList & regions, Address addr, std::size_t length) noexcept;
+
+/** A fast (non-cryptographic) 64-bit hash, for telling whether a region of
+ *  memory changed. Works on four independent 64-bit lanes at a time so the
+ *  compiler may vectorize/pipeline it.
+ */
+uint64_t hash_bytes(const uint8_t *, std::size_t, uint64_t seed = 0) noexcept;
+
 enum EndiannessEnum { k_big_endian, k_little_endian };
 
 void process_endian_u16(uint16_t &, EndiannessEnum);
@@ -71,6 +111,78 @@ private:
 
 void read_memory_to(int pid, Address targets_addr, uint8_t * buffer, std::size_t buffer_len);
 
+/** Outcome of a read for the non-throwing ("try_") family of functions. */
+enum class ReadStatus {
+    ok,
+    bad_address,   // (part of) the range is not mapped/readable in the target
+    no_process,    // target has gone away
+    no_permission, // ptrace permission is needed
+    failed         // anything else
+};
+
+/** @returns ReadStatus corresponding to an errno value (zero is ok) */
+ReadStatus to_read_status(int err) noexcept;
+
+/** A failed read of target memory is something only that read's caller
+ *  should have to care about, a missing target or permission is not.
+ */
+inline bool is_fatal(ReadStatus status) noexcept
+    { return status == ReadStatus::no_process || status == ReadStatus::no_permission; }
+
+/** One piece of a scatter-gather read, "length" bytes starting at "address"
+ *  in the target are copied to "destination".
+ */
+struct ReadRequest {
+    Address     address     = k_no_address;
+    uint8_t *   destination = nullptr;
+    std::size_t length      = 0;
+};
+
+using ReadRequestList = std::vector<ReadRequest>;
+
+/** Answers all requests in [beg end) using as few process_vm_readv calls as
+ *  possible (each call carries up to IOV_MAX requests).
+ *  @throws on the same conditions as the single read version, and also if
+ *          the target could only partially fill the requests
+ */
+void read_memory_to(int pid, const ReadRequest * beg, const ReadRequest * end);
+
+/** Non-throwing versions of read_memory_to, the contents of the destination
+ *  buffer(s) are unspecified on failure.
+ */
+ReadStatus try_read_memory_to
+    (int pid, Address targets_addr, uint8_t * buffer, std::size_t buffer_len) noexcept;
+
+ReadStatus try_read_memory_to
+    (int pid, const ReadRequest * beg, const ReadRequest * end) noexcept;
+
+/** Opens "/proc/<pid>/mem" for reading, an alternative to process_vm_readv
+ *  which may be cheaper on some kernels/seccomp profiles.
+ *  @returns a file descriptor the caller is responsible for closing
+ */
+int open_process_memory(int pid);
+
+/** Reads target memory from a descriptor from open_process_memory with pread.
+ *  @throws on the same conditions as read_memory_to
+ */
+void read_memory_file_to(int fd, Address targets_addr, uint8_t * buffer, std::size_t buffer_len);
+
+/** Batch version, requests which are contiguous in the target are read with
+ *  a single preadv.
+ */
+void read_memory_file_to(int fd, const ReadRequest * beg, const ReadRequest * end);
+
+ReadStatus try_read_memory_file_to
+    (int fd, Address targets_addr, uint8_t * buffer, std::size_t buffer_len) noexcept;
+
+ReadStatus try_read_memory_file_to
+    (int fd, const ReadRequest * beg, const ReadRequest * end) noexcept;
+
+/** @returns the number of process_vm_readv/pread calls made by this program
+ *           so far, useful for seeing what a single refresh costs
+ */
+std::size_t read_memory_syscall_count();
+
 // ------------------------------ string parsing ------------------------------
 
 inline bool is_whitespace    (char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
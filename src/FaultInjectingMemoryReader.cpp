@@ -0,0 +1,235 @@
+/****************************************************************************
+
+    File: FaultInjectingMemoryReader.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "FaultInjectingMemoryReader.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <cstring>
+
+namespace {
+
+using Error = std::runtime_error;
+
+[[noreturn]] void throw_status(Address, ReadStatus);
+
+} // end of <anonymous> namespace
+
+/* static */ FaultProfile FaultProfile::parse(const std::string & settings) {
+    FaultProfile rv;
+    std::size_t pos = 0;
+    while (pos < settings.size()) {
+        auto end = settings.find(',', pos);
+        if (end == std::string::npos) end = settings.size();
+        auto setting = settings.substr(pos, end - pos);
+        pos = end + 1;
+        if (setting.empty()) continue;
+
+        auto eq = setting.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument("FaultProfile::parse: \"" + setting
+                                        + "\" is not of the form name=value.");
+        }
+        auto name  = setting.substr(0, eq);
+        auto value = setting.substr(eq + 1);
+        double number = 0.;
+        try {
+            number = std::stod(value);
+        } catch (std::exception &) {
+            throw std::invalid_argument("FaultProfile::parse: \"" + value
+                                        + "\" is not a number.");
+        }
+        if (number < 0.) {
+            throw std::invalid_argument("FaultProfile::parse: " + name
+                                        + " may not be negative.");
+        }
+        /**/ if (name == "latency") rv.latency          = number;
+        else if (name == "jitter" ) rv.latency_jitter   = number;
+        else if (name == "bad"    ) rv.bad_address_rate = number;
+        else if (name == "gone"   ) rv.no_process_rate  = number;
+        else if (name == "torn"   ) rv.torn_rate        = number;
+        else if (name == "churn"  ) rv.churn_rate       = number;
+        else if (name == "seed"   ) rv.seed             = uint64_t(number);
+        else {
+            throw std::invalid_argument("FaultProfile::parse: unknown setting \""
+                                        + name + "\".");
+        }
+    }
+    return rv;
+}
+
+// ----------------------------------------------------------------------------
+
+FaultInjectingMemoryReader::FaultInjectingMemoryReader
+    (std::shared_ptr<const MemoryReader> source, const FaultProfile & profile):
+    m_source(std::move(source)),
+    m_profile(profile),
+    m_state(profile.seed)
+{
+    if (!m_source) {
+        throw std::invalid_argument("FaultInjectingMemoryReader::FaultInjectingMemoryReader: "
+                                    "source must not be null.");
+    }
+}
+
+void FaultInjectingMemoryReader::read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const
+{
+    auto status = try_read(addr, buf, bytes_in_buf);
+    if (status != ReadStatus::ok) throw_status(addr, status);
+}
+
+void FaultInjectingMemoryReader::read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const
+{
+    delay();
+    for (auto itr = beg; itr != end; ++itr) {
+        ++m_reads;
+        auto status = roll_failure();
+        if (status != ReadStatus::ok) throw_status(itr->address, status);
+    }
+    m_source->read_batch(beg, end);
+    for (auto itr = beg; itr != end; ++itr) {
+        corrupt(itr->destination, itr->length);
+    }
+}
+
+ReadStatus FaultInjectingMemoryReader::try_read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept
+{
+    delay();
+    ++m_reads;
+    auto status = roll_failure();
+    if (status != ReadStatus::ok) return status;
+    status = m_source->try_read(addr, buf, bytes_in_buf);
+    if (status == ReadStatus::ok) corrupt(buf, bytes_in_buf);
+    return status;
+}
+
+ReadStatus FaultInjectingMemoryReader::try_read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const noexcept
+{
+    delay();
+    for (auto itr = beg; itr != end; ++itr) {
+        ++m_reads;
+        auto status = roll_failure();
+        if (status != ReadStatus::ok) return status;
+    }
+    auto status = m_source->try_read_batch(beg, end);
+    if (status != ReadStatus::ok) return status;
+    for (auto itr = beg; itr != end; ++itr) {
+        corrupt(itr->destination, itr->length);
+    }
+    return status;
+}
+
+void FaultInjectingMemoryReader::describe_source(std::ostream & out) const {
+    out << "faults injected into ";
+    m_source->describe_source(out);
+}
+
+FaultCounts FaultInjectingMemoryReader::counts() const noexcept {
+    FaultCounts rv;
+    rv.reads       = m_reads;
+    rv.bad_address = m_bad_address;
+    rv.no_process  = m_no_process;
+    rv.torn        = m_torn;
+    rv.churned     = m_churned;
+    rv.delayed     = double(m_delayed.load()) / 1e9;
+    return rv;
+}
+
+/* private */ double FaultInjectingMemoryReader::next_unit() const noexcept {
+    // top 53 bits make an exactly representable double
+    return double(next_bits() >> 11) * (1. / double(uint64_t(1) << 53));
+}
+
+/* private */ uint64_t FaultInjectingMemoryReader::next_bits() const noexcept {
+    // splitmix64, each call claims its own step of the sequence
+    uint64_t z = m_state.fetch_add(0x9E37'79B9'7F4A'7C15ull) + 0x9E37'79B9'7F4A'7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58'476D'1CE4'E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D0'49BB'1331'11EBull;
+    return z ^ (z >> 31);
+}
+
+/* private */ void FaultInjectingMemoryReader::delay() const noexcept {
+    using namespace std::chrono;
+    auto seconds = m_profile.latency;
+    if (m_profile.latency_jitter > 0.) seconds += m_profile.latency_jitter*next_unit();
+    if (seconds <= 0.) return;
+    auto ns = duration_cast<nanoseconds>(duration<double>(seconds));
+    m_delayed += uint64_t(ns.count());
+    std::this_thread::sleep_for(ns);
+}
+
+/* private */ ReadStatus FaultInjectingMemoryReader::roll_failure() const noexcept {
+    if (roll(m_profile.no_process_rate)) {
+        ++m_no_process;
+        return ReadStatus::no_process;
+    }
+    if (roll(m_profile.bad_address_rate)) {
+        ++m_bad_address;
+        return ReadStatus::bad_address;
+    }
+    return ReadStatus::ok;
+}
+
+/* private */ void FaultInjectingMemoryReader::corrupt
+    (uint8_t * buf, std::size_t length) const noexcept
+{
+    if (length > 1 && roll(m_profile.torn_rate)) {
+        ++m_torn;
+        auto split = 1 + std::size_t(next_bits() % (length - 1));
+        for (auto i = split; i < length; ++i) buf[i] = uint8_t(next_bits());
+    }
+    static constexpr const std::size_t k_pointer_size = sizeof(uint32_t);
+    if (length >= k_pointer_size && roll(m_profile.churn_rate)) {
+        ++m_churned;
+        auto slot = std::size_t(next_bits() % (length / k_pointer_size));
+        uint32_t pointer;
+        std::memcpy(&pointer, buf + slot*k_pointer_size, k_pointer_size);
+        // somewhere else nearby in the heap, still aligned
+        pointer += uint32_t((next_bits() % 0x1000) + 1) * 0x10;
+        std::memcpy(buf + slot*k_pointer_size, &pointer, k_pointer_size);
+    }
+}
+
+namespace {
+
+[[noreturn]] void throw_status(Address addr, ReadStatus status) {
+    switch (status) {
+    case ReadStatus::no_permission:
+        throw PermissionError("Lost permission to read the target's memory.");
+    case ReadStatus::no_process:
+        throw Error("FaultInjectingMemoryReader: injected no process (ESRCH).");
+    case ReadStatus::bad_address:
+        throw Error("FaultInjectingMemoryReader: injected bad address (EFAULT) at "
+                    + std::to_string(addr) + ".");
+    default:
+        throw Error("FaultInjectingMemoryReader: failed to read at "
+                    + std::to_string(addr) + ".");
+    }
+}
+
+} // end of <anonymous> namespace
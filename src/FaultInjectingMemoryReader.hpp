@@ -0,0 +1,121 @@
+/****************************************************************************
+
+    File: FaultInjectingMemoryReader.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "MemoryReader.hpp"
+
+#include <atomic>
+
+/** What faults to inject, and how often. Rates are chances per read (a
+ *  batch counts as one read per request), from zero to one.
+ */
+struct FaultProfile {
+    // added to every read, and once to every batch, as a syscall would be
+    double latency = 0.;
+    // up to this much more latency, uniformly distributed
+    double latency_jitter = 0.;
+    // fails as if the range were unmapped (EFAULT), as during area loads
+    double bad_address_rate = 0.;
+    // fails as if the process were gone (ESRCH)
+    double no_process_rate = 0.;
+    // the tail of the read is garbage, as if the target wrote mid read
+    double torn_rate = 0.;
+    // a pointer sized (four byte, aligned) value read is replaced with
+    // another plausible looking pointer, as if the target reallocated it
+    double churn_rate = 0.;
+    uint64_t seed = 0;
+
+    /** Parses comma separated settings, e.g.
+     *  "latency=0.0005,jitter=0.001,bad=0.01,gone=0.001,torn=0.01,churn=0.01,seed=7"
+     *  (latencies in seconds).
+     *  @throws std::invalid_argument on anything not understood
+     */
+    static FaultProfile parse(const std::string &);
+};
+
+struct FaultCounts {
+    std::size_t reads       = 0;
+    std::size_t bad_address = 0;
+    std::size_t no_process  = 0;
+    std::size_t torn        = 0;
+    std::size_t churned     = 0;
+    double      delayed     = 0.;
+};
+
+/** Passes reads through to its source, injecting latency and faults along
+ *  the way, for seeing how (and how quickly) the item views cope with
+ *  conditions like those of area loads. Faults are random, but repeatable
+ *  for a given seed and sequence of reads. Safe to share between threads
+ *  if the source is.
+ */
+class FaultInjectingMemoryReader final : public MemoryReader {
+public:
+    FaultInjectingMemoryReader(std::shared_ptr<const MemoryReader>, const FaultProfile &);
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    using MemoryReader::read_batch;
+    void read_batch(const ReadRequest * beg, const ReadRequest * end) const override;
+
+    ReadStatus try_read(Address, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override;
+
+    using MemoryReader::try_read_batch;
+    ReadStatus try_read_batch(const ReadRequest * beg, const ReadRequest * end) const noexcept override;
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return m_source->is_readable(addr, length); }
+
+    void describe_source(std::ostream &) const override;
+
+    const FaultProfile & profile() const noexcept { return m_profile; }
+
+    FaultCounts counts() const noexcept;
+
+private:
+    /** @returns a uniformly distributed number in [0 1) */
+    double next_unit() const noexcept;
+
+    uint64_t next_bits() const noexcept;
+
+    bool roll(double rate) const noexcept
+        { return rate > 0. && next_unit() < rate; }
+
+    void delay() const noexcept;
+
+    /** @returns a failure to inject (ok if none) */
+    ReadStatus roll_failure() const noexcept;
+
+    /** Tears and/or churns a successfully read buffer. */
+    void corrupt(uint8_t * buf, std::size_t length) const noexcept;
+
+    std::shared_ptr<const MemoryReader> m_source;
+    FaultProfile m_profile;
+
+    mutable std::atomic<uint64_t> m_state;
+    mutable std::atomic<std::size_t> m_reads       { 0 };
+    mutable std::atomic<std::size_t> m_bad_address { 0 };
+    mutable std::atomic<std::size_t> m_no_process  { 0 };
+    mutable std::atomic<std::size_t> m_torn        { 0 };
+    mutable std::atomic<std::size_t> m_churned     { 0 };
+    // in nanoseconds
+    mutable std::atomic<uint64_t> m_delayed { 0 };
+};
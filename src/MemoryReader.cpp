@@ -20,9 +20,13 @@
 *****************************************************************************/
 
 #include "MemoryReader.hpp"
+#include "ProcessMaps.hpp"
 
 #include <fstream>
 #include <random>
+#include <mutex>
+
+#include <unistd.h>
 
 #include <cassert>
 
@@ -31,24 +35,92 @@ namespace {
 using Error            = std::runtime_error            ;
 using MemoryReaderSPtr = MemoryReader::MemoryReaderSPtr;
 
+/** Region lookups for process readers, process readers are otherwise
+ *  stateless so a lock keeps them safe to share between threads.
+ */
+class GuardedMapIndex {
+public:
+    explicit GuardedMapIndex(int pid): m_index(pid) {}
+
+    bool is_readable(Address addr, std::size_t length) const {
+        std::unique_lock lock { m_mutex };
+        return m_index.is_readable_refreshing(addr, length);
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    mutable ProcessMapIndex m_index;
+};
+
 class ProcessMemoryReader final : public MemoryReader {
 public:
-    ProcessMemoryReader(int pid): m_pid(pid) {}
+    ProcessMemoryReader(int pid): m_pid(pid), m_maps(pid) {}
 
     void read(Address addr, uint8_t * buf, std::size_t bytes_in_buf) const override
         { read_memory_to(m_pid, addr, buf, bytes_in_buf); }
 
+    void read_batch(const ReadRequest * beg, const ReadRequest * end) const override
+        { read_memory_to(m_pid, beg, end); }
+
+    ReadStatus try_read(Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override
+        { return try_read_memory_to(m_pid, addr, buf, bytes_in_buf); }
+
+    ReadStatus try_read_batch(const ReadRequest * beg, const ReadRequest * end) const noexcept override
+        { return try_read_memory_to(m_pid, beg, end); }
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return m_maps.is_readable(addr, length); }
+
     void describe_source(std::ostream & out) const override {
         out << "Process id " << std::dec << m_pid << ".";
     }
 private:
     int m_pid;
+    GuardedMapIndex m_maps;
+};
+
+class ProcessFileMemoryReader final : public MemoryReader {
+public:
+    explicit ProcessFileMemoryReader(int pid):
+        m_pid(pid), m_fd(open_process_memory(pid)), m_maps(pid) {}
+
+    ProcessFileMemoryReader(const ProcessFileMemoryReader &) = delete;
+    ProcessFileMemoryReader & operator = (const ProcessFileMemoryReader &) = delete;
+
+    ~ProcessFileMemoryReader() override { (void)close(m_fd); }
+
+    void read(Address addr, uint8_t * buf, std::size_t bytes_in_buf) const override
+        { read_memory_file_to(m_fd, addr, buf, bytes_in_buf); }
+
+    void read_batch(const ReadRequest * beg, const ReadRequest * end) const override
+        { read_memory_file_to(m_fd, beg, end); }
+
+    ReadStatus try_read(Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override
+        { return try_read_memory_file_to(m_fd, addr, buf, bytes_in_buf); }
+
+    ReadStatus try_read_batch(const ReadRequest * beg, const ReadRequest * end) const noexcept override
+        { return try_read_memory_file_to(m_fd, beg, end); }
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return m_maps.is_readable(addr, length); }
+
+    void describe_source(std::ostream & out) const override {
+        out << "Process id " << std::dec << m_pid << " (/proc/pid/mem).";
+    }
+private:
+    int m_pid;
+    int m_fd;
+    GuardedMapIndex m_maps;
 };
 
 class BuiltinMemoryReader final : public MemoryReader {
 public:
     BuiltinMemoryReader(int offset): m_offset(offset) {}
     void read(Address, uint8_t *, std::size_t) const override;
+    void read_batch(const ReadRequest * beg, const ReadRequest * end) const override;
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return is_in_range(addr, length); }
 
     static std::size_t get_builtin_size() { return get_builtin_data().size(); }
 
@@ -58,6 +130,7 @@ public:
 
 private:
     static const std::vector<uint8_t> & get_builtin_data();
+    bool is_in_range(Address, std::size_t) const;
     int m_offset;
 };
 
@@ -67,6 +140,44 @@ private:
     throw Error("MemoryReader::describe_source: source not meant to be described.");
 }
 
+/* vtable anchor */ void MemoryReader::read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const
+{
+    for (auto itr = beg; itr != end; ++itr) {
+        read(itr->address, itr->destination, itr->length);
+    }
+}
+
+/* vtable anchor */ ReadStatus MemoryReader::try_read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept
+{
+    try {
+        if (!is_readable(addr, bytes_in_buf)) return ReadStatus::bad_address;
+        read(addr, buf, bytes_in_buf);
+    } catch (PermissionError &) {
+        return ReadStatus::no_permission;
+    } catch (...) {
+        return ReadStatus::failed;
+    }
+    return ReadStatus::ok;
+}
+
+/* vtable anchor */ ReadStatus MemoryReader::try_read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const noexcept
+{
+    try {
+        read_batch(beg, end);
+    } catch (PermissionError &) {
+        return ReadStatus::no_permission;
+    } catch (...) {
+        return ReadStatus::failed;
+    }
+    return ReadStatus::ok;
+}
+
+/* vtable anchor */ bool MemoryReader::is_readable(Address, std::size_t) const
+    { return true; }
+
  int8_t  MemoryReader::read_i8 (Address addr) const { return read_datum< int8_t >(addr); }
 uint8_t  MemoryReader::read_u8 (Address addr) const { return read_datum<uint8_t >(addr); }
  int16_t MemoryReader::read_i16(Address addr) const { return read_datum< int16_t>(addr); }
@@ -86,8 +197,14 @@ double MemoryReader::read_f64(Address addr) const {
     return read_datum<double>(addr);
 }
 
-/* static */ MemoryReaderSPtr MemoryReader::make_process_reader(int pid) {
-    return std::make_shared<ProcessMemoryReader>(pid);
+/* static */ MemoryReaderSPtr MemoryReader::make_process_reader
+    (int pid, ProcessReadMethod method)
+{
+    switch (method) {
+    case k_process_vm_readv: return std::make_shared<ProcessMemoryReader>(pid);
+    case k_proc_pid_mem    : return std::make_shared<ProcessFileMemoryReader>(pid);
+    }
+    throw std::invalid_argument("MemoryReader::make_process_reader: read method not valid.");
 }
 
 /* static */ MemoryReaderSPtr MemoryReader::make_builtin_reader(int offset) {
@@ -106,22 +223,110 @@ double MemoryReader::read_f64(Address addr) const {
     std::copy(m_block, m_block + bsize, buf);
 }
 
+void SimpleBlockReader::read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const
+{
+    // check everything first, so that a failed batch writes nothing
+    for (auto itr = beg; itr != end; ++itr) {
+        if (itr->length > m_size) {
+            throw Error("SimpleBlockReader::read_batch: cannot fill request.");
+        }
+    }
+    for (auto itr = beg; itr != end; ++itr) {
+        std::copy(m_block, m_block + itr->length, itr->destination);
+    }
+}
+
+void LocalBlockReader::read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const
+{
+    if (contains(addr, bytes_in_buf)) {
+        std::copy(m_block + (addr - m_base), m_block + (addr - m_base) + bytes_in_buf, buf);
+    } else if (m_fallback) {
+        m_fallback->read(addr, buf, bytes_in_buf);
+    } else {
+        throw Error("LocalBlockReader::read: address range is outside of the block.");
+    }
+}
+
+ReadStatus LocalBlockReader::try_read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept
+{
+    if (contains(addr, bytes_in_buf)) {
+        std::copy(m_block + (addr - m_base), m_block + (addr - m_base) + bytes_in_buf, buf);
+        return ReadStatus::ok;
+    } else if (m_fallback) {
+        return m_fallback->try_read(addr, buf, bytes_in_buf);
+    }
+    return ReadStatus::bad_address;
+}
+
+bool LocalBlockReader::is_readable(Address addr, std::size_t length) const {
+    if (contains(addr, length)) return true;
+    return m_fallback && m_fallback->is_readable(addr, length);
+}
+
+void LocalBlockReader::describe_source(std::ostream & out) const {
+    out << "Local copy of " << std::dec << m_size << " bytes at 0x" << std::hex
+        << m_base << std::dec << ".";
+}
+
+void CheckedMemoryReader::read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const
+{
+    auto status = m_source.try_read(addr, buf, bytes_in_buf);
+    if (status == ReadStatus::ok) return;
+    std::fill(buf, buf + bytes_in_buf, uint8_t(0));
+    note(status);
+}
+
+void CheckedMemoryReader::read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const
+{
+    auto status = m_source.try_read_batch(beg, end);
+    if (status == ReadStatus::ok) return;
+    for (auto itr = beg; itr != end; ++itr) {
+        std::fill(itr->destination, itr->destination + itr->length, uint8_t(0));
+    }
+    note(status);
+}
+
 namespace {
 
 template <typename T, typename U>
 void append_data(std::vector<uint8_t> &, std::initializer_list<U>);
 
 void BuiltinMemoryReader::read(Address addr, uint8_t * buf, std::size_t bytes_in_buf) const {
-    bool is_under = int(addr) < m_offset;
-    addr -= m_offset;
-    if (is_under || addr + bytes_in_buf > get_builtin_data().size()) {
+    if (!is_in_range(addr, bytes_in_buf)) {
         throw Error("BuiltinMemoryReader::read: Address is not in range of the builtin data.");
     }
 
-    auto start = get_builtin_data().begin() + addr;
+    auto start = get_builtin_data().begin() + (addr - m_offset);
     std::copy(start, start + bytes_in_buf, buf);
 }
 
+void BuiltinMemoryReader::read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const
+{
+    // check everything first, so that a failed batch writes nothing
+    for (auto itr = beg; itr != end; ++itr) {
+        if (!is_in_range(itr->address, itr->length)) {
+            throw Error("BuiltinMemoryReader::read_batch: Address is not in range of the builtin data.");
+        }
+    }
+    for (auto itr = beg; itr != end; ++itr) {
+        auto start = get_builtin_data().begin() + (itr->address - m_offset);
+        std::copy(start, start + itr->length, itr->destination);
+    }
+}
+
+/* private */ bool BuiltinMemoryReader::is_in_range
+    (Address addr, std::size_t length) const
+{
+    if (int(addr) < m_offset) return false;
+    return (addr - m_offset) + length <= get_builtin_data().size();
+}
+
 /* static */ const std::vector<uint8_t> &
     BuiltinMemoryReader::get_builtin_data()
 {
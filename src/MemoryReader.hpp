@@ -23,6 +23,7 @@
 
 #include "Defs.hpp"
 #include <memory>
+#include <optional>
 
 class MemoryReader {
 public:
@@ -30,13 +31,52 @@ public:
 
     static constexpr const char * const k_builtin_string = "builtin";
 
+    enum ProcessReadMethod {
+        k_process_vm_readv, // one syscall per read (or per batch)
+        k_proc_pid_mem      // pread on a persistent /proc/<pid>/mem descriptor
+    };
+
     virtual ~MemoryReader() {}
     virtual void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const = 0;
     virtual void describe_source(std::ostream &) const;
 
+    /** Answers every request in [beg end), readers that can do so should
+     *  answer them with fewer round trips than one read per request.
+     *  The default implementation simply reads each request one by one.
+     */
+    virtual void read_batch(const ReadRequest * beg, const ReadRequest * end) const;
+
+    void read_batch(const ReadRequestList & requests) const
+        { read_batch(requests.data(), requests.data() + requests.size()); }
+
+    /** Non-throwing read, for hot loops where a failed read should only
+     *  spoil the one thing being read. The default implementation goes
+     *  through read and catches.
+     */
+    virtual ReadStatus try_read(Address, uint8_t * buf, std::size_t bytes_in_buf) const noexcept;
+
+    /** Non-throwing version of read_batch, all or nothing.
+     *  @returns status of the first request that failed (or ok)
+     */
+    virtual ReadStatus try_read_batch(const ReadRequest * beg, const ReadRequest * end) const noexcept;
+
+    ReadStatus try_read_batch(const ReadRequestList & requests) const noexcept
+        { return try_read_batch(requests.data(), requests.data() + requests.size()); }
+
+    /** A cheap check that [addr, addr + length) can be read, without reading
+     *  it. Readers that cannot tell return true and leave it to read.
+     */
+    virtual bool is_readable(Address addr, std::size_t length) const;
+
     template <typename T>
     T read_datum(Address addr) const;
 
+    /** @returns an empty optional if the read fails, status (if given) is
+     *           set to the read's outcome
+     */
+    template <typename T>
+    std::optional<T> try_read_datum(Address addr, ReadStatus * status = nullptr) const noexcept;
+
     // named reader functions
     int8_t read_i8(Address) const;
     uint8_t read_u8(Address) const;
@@ -50,19 +90,101 @@ public:
     float read_f32(Address) const;
     double read_f64(Address) const;
 
-    static MemoryReaderSPtr make_process_reader(int pid);
+    static MemoryReaderSPtr make_process_reader
+        (int pid, ProcessReadMethod = k_process_vm_readv);
     static MemoryReaderSPtr make_builtin_reader(int offset);
     static int get_builtin_size();
 };
 
+/** @returns a request to read sizeof(T) bytes at addr straight into obj */
+template <typename T>
+ReadRequest make_read_request(Address addr, T & obj) {
+    static_assert(std::is_arithmetic_v<T>, "Can only read PoD/arithmetic types.");
+    return ReadRequest { addr, reinterpret_cast<uint8_t *>(&obj), sizeof(T) };
+}
+
 class SimpleBlockReader final : public MemoryReader {
 public:
     SimpleBlockReader(const uint8_t * p, std::size_t size):
         m_block(p), m_size(size) {}
     void read(Address, uint8_t * buf, std::size_t bsize) const override;
+    using MemoryReader::read_batch;
+    void read_batch(const ReadRequest * beg, const ReadRequest * end) const override;
+private:
+    const uint8_t * m_block;
+    std::size_t m_size;
+};
+
+/** Serves reads of [base, base + size) out of a local buffer, so a record
+ *  fetched in one read can be decoded by code written against the
+ *  MemoryReader interface. Reads outside of the block go to the fallback
+ *  reader if there is one, and throw otherwise.
+ */
+class LocalBlockReader final : public MemoryReader {
+public:
+    LocalBlockReader(Address base, const uint8_t * block, std::size_t size,
+                     const MemoryReader * fallback = nullptr):
+        m_base(base), m_block(block), m_size(size), m_fallback(fallback) {}
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    ReadStatus try_read(Address, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override;
+
+    bool is_readable(Address addr, std::size_t length) const override;
+
+    void describe_source(std::ostream &) const override;
+
+    bool contains(Address addr, std::size_t length) const noexcept
+        { return addr >= m_base && addr - m_base + length <= m_size; }
+
 private:
+    Address m_base;
     const uint8_t * m_block;
     std::size_t m_size;
+    const MemoryReader * m_fallback;
+};
+
+/** Decorates another reader so that nothing it is asked to read throws.
+ *  A failed read zero fills its buffer and is remembered (the first failure
+ *  sticks until reset). This lets code written against the plain throwing
+ *  interface (like item decoders) run exception free, with the caller
+ *  checking status() once at the end.
+ */
+class CheckedMemoryReader final : public MemoryReader {
+public:
+    explicit CheckedMemoryReader(const MemoryReader & source):
+        m_source(source) {}
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    using MemoryReader::read_batch;
+    void read_batch(const ReadRequest * beg, const ReadRequest * end) const override;
+
+    ReadStatus try_read(Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override
+        { return m_source.try_read(addr, buf, bytes_in_buf); }
+
+    using MemoryReader::try_read_batch;
+    ReadStatus try_read_batch(const ReadRequest * beg, const ReadRequest * end) const noexcept override
+        { return m_source.try_read_batch(beg, end); }
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return m_source.is_readable(addr, length); }
+
+    void describe_source(std::ostream & out) const override
+        { m_source.describe_source(out); }
+
+    ReadStatus status() const noexcept { return m_status; }
+
+    bool good() const noexcept { return m_status == ReadStatus::ok; }
+
+    void reset() noexcept { m_status = ReadStatus::ok; }
+
+private:
+    void note(ReadStatus status) const noexcept
+        { if (m_status == ReadStatus::ok) m_status = status; }
+
+    const MemoryReader & m_source;
+    mutable ReadStatus m_status = ReadStatus::ok;
 };
 
 // ----------------------------------------------------------------------------
@@ -74,3 +196,15 @@ T MemoryReader::read_datum(Address addr) const {
     read(addr, reinterpret_cast<uint8_t *>(&obj), sizeof(T));
     return obj;
 }
+
+template <typename T>
+std::optional<T> MemoryReader::try_read_datum
+    (Address addr, ReadStatus * status) const noexcept
+{
+    static_assert(std::is_arithmetic_v<T>, "Can only read PoD/arithmetic types.");
+    T obj;
+    auto res = try_read(addr, reinterpret_cast<uint8_t *>(&obj), sizeof(T));
+    if (status) *status = res;
+    if (res != ReadStatus::ok) return {};
+    return obj;
+}
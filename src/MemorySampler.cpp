@@ -0,0 +1,140 @@
+/****************************************************************************
+
+    File: MemorySampler.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include "MemorySampler.hpp"
+#include "MemoryReader.hpp"
+#include "ReadProfile.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+MemorySampler::MemorySampler
+    (std::shared_ptr<const MemoryReader> memory, RegionProvider provider,
+     double rate_hz):
+    m_memory(std::move(memory)),
+    m_provider(std::move(provider)),
+    m_rate(rate_hz),
+    m_start(Clock::now()),
+    m_last_drain(m_start.time_since_epoch().count())
+{
+    if (!m_memory || !m_provider) {
+        throw std::invalid_argument("MemorySampler::MemorySampler: memory "
+                                    "reader and region provider must both be set.");
+    }
+    if (!(rate_hz > 0.)) {
+        throw std::invalid_argument("MemorySampler::MemorySampler: rate must "
+                                    "be a positive number.");
+    }
+    m_thread = std::thread([this]() { run(); });
+}
+
+MemorySampler::~MemorySampler() {
+    {
+    std::unique_lock<std::mutex> lock(m_stop_mutex);
+    m_stopping = true;
+    }
+    m_stop_signal.notify_all();
+    m_thread.join();
+}
+
+/* private */ void MemorySampler::run() {
+    using namespace std::chrono;
+    const auto period = duration_cast<Clock::duration>(duration<double>(1. / m_rate));
+    auto next = Clock::now();
+    std::unique_lock<std::mutex> lock(m_stop_mutex);
+    while (!m_stopping) {
+        if (!is_idle()) {
+            lock.unlock();
+            poll();
+            lock.lock();
+        }
+        // fell behind? don't try to catch up
+        next = std::max(next + period, Clock::now());
+        m_stop_signal.wait_until(lock, next, [this]() { return m_stopping; });
+    }
+}
+
+/* private */ void MemorySampler::poll() {
+    static ReadSite s_site("sampler");
+    ReadSiteScope scope(s_site);
+    auto poll_number = ++m_poll_count;
+    m_region_list.clear();
+    try {
+        m_provider(*m_memory, m_region_list);
+    } catch (...) {
+        // the target is likely in flux, the UI thread is the one to act on
+        // any lasting problem
+        return;
+    }
+
+    std::size_t total = 0;
+    for (const auto & region : m_region_list) total += region.length;
+    m_buffer.resize(total);
+    m_requests.clear();
+    auto * dest = m_buffer.data();
+    for (const auto & region : m_region_list) {
+        m_requests.push_back(ReadRequest { region.address, dest, region.length });
+        dest += region.length;
+    }
+    bool all_good = m_memory->try_read_batch(m_requests) == ReadStatus::ok;
+
+    for (const auto & request : m_requests) {
+        if (!all_good && m_memory->try_read(request.address, request.destination,
+                                            request.length) != ReadStatus::ok)
+        { continue; }
+        auto & region = m_regions[request.address];
+        const auto * beg = request.destination;
+        const auto * end = beg + request.length;
+        bool changed = !std::equal(beg, end, region.bytes.begin(), region.bytes.end());
+        // a dropped delta leaves the old bytes, so it's tried again
+        if (changed && publish(request.address, beg, end)) {
+            region.bytes.assign(beg, end);
+        }
+        region.last_poll = poll_number;
+    }
+
+    for (auto itr = m_regions.begin(); itr != m_regions.end(); ) {
+        if (itr->second.last_poll != poll_number && publish(itr->first, nullptr, nullptr)) {
+            itr = m_regions.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+/* private */ bool MemorySampler::publish
+    (Address addr, const uint8_t * beg, const uint8_t * end)
+{
+    using namespace std::chrono;
+    SampleDelta delta;
+    delta.timestamp = duration<double>(Clock::now() - m_start).count();
+    delta.address   = addr;
+    delta.bytes.assign(beg, end);
+    if (m_ring.try_push(std::move(delta))) return true;
+    ++m_dropped;
+    return false;
+}
+
+/* private */ bool MemorySampler::is_idle() const noexcept {
+    auto last = Clock::time_point(Clock::duration(m_last_drain.load()));
+    return Clock::now() - last > k_idle_after;
+}
@@ -0,0 +1,144 @@
+/****************************************************************************
+
+    File: MemorySampler.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include "Defs.hpp"
+#include "SpscRing.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+class MemoryReader;
+
+struct SampleDelta {
+    // seconds since the sampler started
+    double  timestamp = 0.;
+    Address address   = k_no_address;
+    // the region's new contents, empty if the region is gone (no longer
+    // provided, or no longer readable)
+    std::vector<uint8_t> bytes;
+};
+
+/** Polls regions of the target on its own thread, at a fixed rate, and
+ *  publishes every change it sees through a lock-free ring which the UI
+ *  drains once per frame. Catches changes that come and go faster than the
+ *  UI ticks.
+ *
+ *  Regions are asked of a provider before each poll (so they may follow
+ *  pointers), the provider runs on the sampler thread.
+ *  The source reader must be safe to use from the sampler thread, that is
+ *  not the UI's caching reader.
+ *
+ *  Polling pauses while nothing drains the ring.
+ */
+class MemorySampler {
+public:
+    using RegionProvider = std::function<void(const MemoryReader &, MemoryRegionList &)>;
+
+    static constexpr const std::size_t k_ring_capacity = 1024;
+    static constexpr const double      k_default_rate  = 200.;
+
+    MemorySampler(std::shared_ptr<const MemoryReader>, RegionProvider,
+                  double rate_hz = k_default_rate);
+
+    MemorySampler(const MemorySampler &) = delete;
+    MemorySampler & operator = (const MemorySampler &) = delete;
+
+    ~MemorySampler();
+
+    /** Consumer only. Calls f(SampleDelta &&) for each published delta, in
+     *  the order they were published.
+     *  @returns number of deltas drained
+     */
+    template <typename Func>
+    std::size_t drain(Func && f);
+
+    const MemoryReader & source() const noexcept { return *m_memory; }
+
+    double rate() const noexcept { return m_rate; }
+
+    /** @returns number of deltas not published because the ring was full
+     *           (they are retried next poll)
+     */
+    std::size_t dropped_count() const noexcept { return m_dropped.load(); }
+
+    std::size_t poll_count() const noexcept { return m_poll_count.load(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr const auto k_idle_after = std::chrono::seconds(1);
+
+    struct Region {
+        std::vector<uint8_t> bytes;
+        std::size_t          last_poll = 0;
+    };
+
+    void run();
+    void poll();
+    bool publish(Address, const uint8_t * beg, const uint8_t * end);
+    bool is_idle() const noexcept;
+
+    std::shared_ptr<const MemoryReader> m_memory;
+    RegionProvider m_provider;
+    double m_rate;
+    Clock::time_point m_start;
+
+    SpscRing<SampleDelta, k_ring_capacity> m_ring;
+    std::atomic<Clock::rep> m_last_drain;
+    std::atomic<std::size_t> m_dropped    { 0 };
+    std::atomic<std::size_t> m_poll_count { 0 };
+
+    // sampler thread only
+    std::unordered_map<Address, Region> m_regions;
+    MemoryRegionList m_region_list;
+    ReadRequestList  m_requests;
+    std::vector<uint8_t> m_buffer;
+
+    std::mutex m_stop_mutex;
+    std::condition_variable m_stop_signal;
+    bool m_stopping = false;
+    // last, so that everything else is ready before it starts
+    std::thread m_thread;
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename Func>
+std::size_t MemorySampler::drain(Func && f) {
+    m_last_drain.store(Clock::now().time_since_epoch().count());
+    std::size_t count = 0;
+    SampleDelta delta;
+    while (m_ring.try_pop(delta)) {
+        f(std::move(delta));
+        delta = SampleDelta();
+        ++count;
+    }
+    return count;
+}
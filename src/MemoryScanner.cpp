@@ -0,0 +1,340 @@
+/****************************************************************************
+
+    File: MemoryScanner.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include "MemoryScanner.hpp"
+#include "MemoryReader.hpp"
+#include "ProcessMaps.hpp"
+#include "ReadProfile.hpp"
+
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+
+#include <cassert>
+
+namespace {
+
+static constexpr const std::size_t k_page_size = 4096;
+
+struct ScanChunk {
+    MemoryRegion         region;
+    std::vector<Address> hits;
+    std::size_t          bytes_skipped = 0;
+    bool                 done          = false;
+};
+
+/** Appends the address of every (aligned) match in buf to hits.
+ *  base must be aligned to the value's width.
+ */
+void find_matches
+    (const uint8_t * buf, std::size_t length, Address base,
+     const ScanValue &, std::vector<Address> & hits);
+
+void scan_chunk
+    (const MemoryReader &, const ScanValue &, std::vector<uint8_t> & buffer,
+     ScanChunk &);
+
+/** The worker threads of one scan. However the scan is left (a recorder may
+ *  throw), they are told to stop taking chunks and are joined, rather than
+ *  destroyed while still joinable.
+ */
+class ScanWorkers final {
+public:
+    ScanWorkers(std::atomic<std::size_t> & next_chunk, std::size_t chunk_count):
+        m_next_chunk(next_chunk), m_chunk_count(chunk_count) {}
+
+    ScanWorkers(const ScanWorkers &) = delete;
+    ScanWorkers & operator = (const ScanWorkers &) = delete;
+
+    ~ScanWorkers();
+
+    template <typename Func>
+    void start(std::size_t thread_count, const Func &);
+
+    void join();
+
+private:
+    std::atomic<std::size_t> & m_next_chunk;
+    std::size_t m_chunk_count;
+    std::vector<std::thread> m_threads;
+};
+
+} // end of <anonymous> namespace
+
+/* static */ ScanValue ScanValue::make_f32(float x) {
+    uint32_t bits;
+    static_assert(sizeof(float) == sizeof(uint32_t), "");
+    std::memcpy(&bits, &x, sizeof(float));
+    return ScanValue(k_f32, bits);
+}
+
+/* static */ std::size_t ScanValue::width_of(Type type) noexcept {
+    switch (type) {
+    case k_u8 : return 1;
+    case k_u16: return 2;
+    case k_u32: case k_f32: return 4;
+    }
+    return 1;
+}
+
+// ----------------------------------------------------------------------------
+
+MemoryScanner::MemoryScanner(const MemoryReader & memory, int thread_count):
+    m_memory(&memory),
+    m_thread_count(thread_count)
+{
+    if (thread_count < 0) {
+        throw std::invalid_argument("MemoryScanner::MemoryScanner: thread "
+                                    "count must be a non-negative integer.");
+    }
+    if (m_thread_count == 0) {
+        m_thread_count = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+}
+
+ScanStats MemoryScanner::scan
+    (const MemoryRegionList & regions, const ScanValue & value,
+     MemoryRecorder & recorder) const
+{
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    ScanStats stats;
+
+    // split into chunks, aligning each region to the value's width
+    std::vector<ScanChunk> chunks;
+    auto width = value.width();
+    for (const auto & region : regions) {
+        Address beg = region.address + (width - region.address % width) % width;
+        Address end = region.end() - region.end() % width;
+        if (end <= beg) continue;
+        ++stats.regions_scanned;
+        for (Address addr = beg; addr < end; addr += k_chunk_size) {
+            ScanChunk chunk;
+            chunk.region = MemoryRegion { addr, std::min(std::size_t(end - addr), k_chunk_size) };
+            chunks.push_back(std::move(chunk));
+        }
+    }
+
+    std::mutex mtx;
+    std::condition_variable chunk_done;
+    std::atomic<std::size_t> next_chunk(0);
+    auto worker = [&]() {
+        static ReadSite s_site("memory scan");
+        ReadSiteScope scope(s_site);
+        std::vector<uint8_t> buffer;
+        for (auto i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+            scan_chunk(*m_memory, value, buffer, chunks[i]);
+            std::unique_lock<std::mutex> lock(mtx);
+            chunks[i].done = true;
+            chunk_done.notify_all();
+        }
+    };
+
+    // declared after everything the workers use, so it goes first
+    ScanWorkers workers(next_chunk, chunks.size());
+    workers.start(std::min(std::size_t(m_thread_count), chunks.size()), worker);
+
+    // stream results to the recorder in address order, while the rest of
+    // the chunks are still being worked on
+    uint8_t value_bytes[sizeof(uint32_t)];
+    auto bits = value.bits();
+    std::memcpy(value_bytes, &bits, sizeof(uint32_t));
+    for (auto & chunk : chunks) {
+        {
+        std::unique_lock<std::mutex> lock(mtx);
+        chunk_done.wait(lock, [&chunk]() { return chunk.done; });
+        }
+        for (auto addr : chunk.hits) {
+            recorder.record(addr, value_bytes, width);
+        }
+        stats.hits          += chunk.hits.size();
+        stats.bytes_skipped += chunk.bytes_skipped;
+        stats.bytes_scanned += chunk.region.length - chunk.bytes_skipped;
+        chunk.hits = std::vector<Address>();
+    }
+    workers.join();
+
+    stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+/* static */ MemoryRegionList MemoryScanner::process_regions(int pid)
+    { return ProcessMapIndex(pid).readable_regions(); }
+
+// ----------------------------------------------------------------------------
+
+ScanStats run_scanner_benchmark(int thread_count, std::size_t block_size) {
+    // a block of filler, with the value planted every so often at known
+    // offsets (filler bytes can never form the value)
+    static constexpr const uint32_t    k_planted      = 0x1234ABCD;
+    static constexpr const uint8_t     k_filler       = 0xA5;
+    static constexpr const std::size_t k_plant_stride = 64*1024 + 4;
+
+    block_size -= block_size % sizeof(uint32_t);
+    std::vector<uint8_t> block(block_size, k_filler);
+    std::vector<Address> planted;
+    // planted addresses are aligned, since the heap block is
+    for (std::size_t offset = 0; offset + sizeof(uint32_t) <= block.size(); offset += k_plant_stride) {
+        std::memcpy(block.data() + offset, &k_planted, sizeof(uint32_t));
+        planted.push_back(Address(reinterpret_cast<std::uintptr_t>(block.data() + offset)));
+    }
+
+    auto memory = MemoryReader::make_process_reader(int(getpid()));
+    MemoryScanner scanner(*memory, thread_count);
+    std::vector<Address> hits;
+    AddressRecorder recorder(hits);
+    MemoryRegionList regions = { MemoryRegion {
+        Address(reinterpret_cast<std::uintptr_t>(block.data())), block.size() } };
+    auto stats = scanner.scan(regions, ScanValue::make_u32(k_planted), recorder);
+    if (hits != planted) {
+        throw std::runtime_error("run_scanner_benchmark: scanner did not find "
+                                 "exactly the planted values.");
+    }
+    return stats;
+}
+
+namespace {
+
+template <typename T>
+void find_matches_scalar
+    (const uint8_t * beg, const uint8_t * end, Address base, T value,
+     std::vector<Address> & hits)
+{
+    for (auto itr = beg; end - itr >= int(sizeof(T)); itr += sizeof(T)) {
+        T x;
+        std::memcpy(&x, itr, sizeof(T));
+        if (x == value) hits.push_back(base + Address(itr - beg));
+    }
+}
+
+void find_matches_scalar
+    (const uint8_t * beg, const uint8_t * end, Address base,
+     const ScanValue & value, std::vector<Address> & hits)
+{
+    auto bits = value.bits();
+    switch (value.type()) {
+    case ScanValue::k_u8 : return find_matches_scalar(beg, end, base, uint8_t (bits), hits);
+    case ScanValue::k_u16: return find_matches_scalar(beg, end, base, uint16_t(bits), hits);
+    case ScanValue::k_u32: return find_matches_scalar(beg, end, base, bits, hits);
+    case ScanValue::k_f32: {
+        float f;
+        std::memcpy(&f, &bits, sizeof(float));
+        return find_matches_scalar(beg, end, base, f, hits);
+        }
+    }
+}
+
+void find_matches
+    (const uint8_t * buf, std::size_t length, Address base,
+     const ScanValue & value, std::vector<Address> & hits)
+{
+    assert(base % value.width() == 0);
+    std::size_t i = 0;
+#   ifdef __SSE2__
+    static constexpr const std::size_t k_lane_bytes = sizeof(__m128i);
+    const auto bits = value.bits();
+    const __m128i needle = [&value, bits]() {
+        switch (value.type()) {
+        case ScanValue::k_u8 : return _mm_set1_epi8 (char (bits));
+        case ScanValue::k_u16: return _mm_set1_epi16(short(bits));
+        default              : return _mm_set1_epi32(int  (bits));
+        }
+    } ();
+    const auto width = unsigned(value.width());
+    const unsigned lane_mask = (1u << width) - 1u;
+    for (; i + k_lane_bytes <= length; i += k_lane_bytes) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+        __m128i eq;
+        switch (value.type()) {
+        case ScanValue::k_u8 : eq = _mm_cmpeq_epi8 (block, needle); break;
+        case ScanValue::k_u16: eq = _mm_cmpeq_epi16(block, needle); break;
+        case ScanValue::k_f32:
+            eq = _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(block),
+                                               _mm_castsi128_ps(needle)));
+            break;
+        default              : eq = _mm_cmpeq_epi32(block, needle); break;
+        }
+        // one bit per byte, each match sets width bits
+        auto mask = unsigned(_mm_movemask_epi8(eq));
+        while (mask) {
+            auto bit = unsigned(__builtin_ctz(mask));
+            hits.push_back(base + Address(i + bit));
+            mask &= ~(lane_mask << bit);
+        }
+    }
+#   endif
+    find_matches_scalar(buf + i, buf + length, base + Address(i), value, hits);
+}
+
+void scan_chunk
+    (const MemoryReader & memory, const ScanValue & value,
+     std::vector<uint8_t> & buffer, ScanChunk & chunk)
+{
+    const auto & region = chunk.region;
+    buffer.resize(region.length);
+    if (memory.try_read(region.address, buffer.data(), region.length) == ReadStatus::ok) {
+        find_matches(buffer.data(), region.length, region.address, value, chunk.hits);
+        return;
+    }
+    // some of it may still be readable, go page by page
+    for (Address addr = region.address; addr < region.end(); ) {
+        auto next = std::min(region.end(), (addr / k_page_size + 1)*k_page_size);
+        auto length = std::size_t(next - addr);
+        if (memory.try_read(addr, buffer.data(), length) == ReadStatus::ok) {
+            find_matches(buffer.data(), length, addr, value, chunk.hits);
+        } else {
+            chunk.bytes_skipped += length;
+        }
+        addr = next;
+    }
+}
+
+ScanWorkers::~ScanWorkers() {
+    m_next_chunk = m_chunk_count;
+    join();
+}
+
+template <typename Func>
+void ScanWorkers::start(std::size_t thread_count, const Func & f) {
+    // reserved first, so that a thread is never left out of the vector
+    m_threads.reserve(thread_count);
+    for (std::size_t i = 0; i != thread_count; ++i) {
+        m_threads.emplace_back(f);
+    }
+}
+
+void ScanWorkers::join() {
+    for (auto & thread : m_threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,104 @@
+/****************************************************************************
+
+    File: MemoryScanner.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include "Defs.hpp"
+
+class MemoryReader;
+
+/** A value to look for, compared by bit pattern (except for f32, which
+ *  compares as a float).
+ */
+class ScanValue {
+public:
+    enum Type { k_u8, k_u16, k_u32, k_f32 };
+
+    static ScanValue make_u8 (uint8_t  x) { return ScanValue(k_u8 , x); }
+    static ScanValue make_u16(uint16_t x) { return ScanValue(k_u16, x); }
+    static ScanValue make_u32(uint32_t x) { return ScanValue(k_u32, x); }
+    static ScanValue make_f32(float);
+
+    Type type() const noexcept { return m_type; }
+
+    uint32_t bits() const noexcept { return m_bits; }
+
+    /** @returns size of the value in bytes, values are only looked for at
+     *           addresses aligned to this
+     */
+    std::size_t width() const noexcept { return width_of(m_type); }
+
+    static std::size_t width_of(Type) noexcept;
+
+private:
+    ScanValue(Type type_, uint32_t bits_): m_type(type_), m_bits(bits_) {}
+
+    Type     m_type;
+    uint32_t m_bits;
+};
+
+struct ScanStats {
+    std::size_t bytes_scanned   = 0;
+    std::size_t regions_scanned = 0;
+    // chunks which could not be read (whole or in part)
+    std::size_t bytes_skipped   = 0;
+    std::size_t hits            = 0;
+    double      seconds         = 0.;
+
+    double gigabytes_per_second() const noexcept
+        { return seconds > 0. ? double(bytes_scanned) / (seconds*1e9) : 0.; }
+};
+
+/** Looks for a value across many regions of a target, splitting the work
+ *  into chunks shared among a pool of threads.
+ *
+ *  The reader must be safe to call from several threads at once (the process
+ *  and snapshot readers are, the caching reader is not).
+ */
+class MemoryScanner {
+public:
+    static constexpr const std::size_t k_chunk_size = std::size_t(1) << 20;
+
+    /** @param thread_count zero uses one thread per hardware thread */
+    explicit MemoryScanner(const MemoryReader &, int thread_count = 0);
+
+    /** Scans each region for the value, hits are handed to the recorder on
+     *  the calling thread, in address order, as soon as each chunk is done.
+     *  (the recorder is handed the address, and the bytes of the value)
+     */
+    ScanStats scan(const MemoryRegionList &, const ScanValue &, MemoryRecorder &) const;
+
+    /** @returns every readable region of a process, per "/proc/<pid>/maps" */
+    static MemoryRegionList process_regions(int pid);
+
+    int thread_count() const noexcept { return m_thread_count; }
+
+private:
+    const MemoryReader * m_memory;
+    int m_thread_count;
+};
+
+/** Scans this very process for values planted at known places in a large
+ *  heap block, and reports the scanner's throughput.
+ *  @throws if any planted value is not found
+ */
+ScanStats run_scanner_benchmark(int thread_count = 0, std::size_t block_size = std::size_t(256) << 20);
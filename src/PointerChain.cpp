@@ -0,0 +1,104 @@
+/****************************************************************************
+
+    File: PointerChain.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include "PointerChain.hpp"
+#include "MemoryReader.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+PointerChain::PointerChain(Address root_, std::size_t root_width_):
+    m_root(root_),
+    m_root_width(root_width_)
+{
+    if (root_width_ != 1 && root_width_ != 2 && root_width_ != 4) {
+        throw std::invalid_argument("PointerChain::PointerChain: root width "
+                                    "must be one, two or four bytes.");
+    }
+}
+
+PointerChain & PointerChain::mask(uint32_t mask_) {
+    m_steps.push_back(Step { k_mask, Address(mask_) });
+    return *this;
+}
+
+PointerChain & PointerChain::offset(Address offset_) {
+    m_steps.push_back(Step { k_offset, offset_ });
+    return *this;
+}
+
+PointerChain & PointerChain::dereference() {
+    m_steps.push_back(Step { k_dereference, 0 });
+    return *this;
+}
+
+bool PointerChain::has_dereferences() const noexcept {
+    return std::any_of(m_steps.begin(), m_steps.end(),
+        [](const Step & step) { return step.kind == k_dereference; });
+}
+
+Address PointerChain::walk(const MemoryReader & memory, uint32_t root_value) const {
+    Address value = root_value;
+    for (const auto & step : m_steps) {
+        switch (step.kind) {
+        case k_mask: value &= step.operand; break;
+        case k_offset:
+            if (value) value += step.operand;
+            break;
+        case k_dereference:
+            if (value) value = memory.read_u32(value);
+            break;
+        }
+    }
+    return value;
+}
+
+// ----------------------------------------------------------------------------
+
+PointerChainResolver::ChainId PointerChainResolver::add(PointerChain chain) {
+    m_chains.push_back(std::move(chain));
+    m_root_values    .push_back(0);
+    m_new_root_values.push_back(0);
+    m_values         .push_back(0);
+    m_resolved       .push_back(false);
+    return m_chains.size() - 1;
+}
+
+void PointerChainResolver::update(const MemoryReader & memory) {
+    // values are little endian, and narrower roots leave the upper bytes zero
+    m_requests.clear();
+    for (std::size_t i = 0; i != m_chains.size(); ++i) {
+        m_new_root_values[i] = 0;
+        m_requests.push_back(ReadRequest {
+            m_chains[i].root(), reinterpret_cast<uint8_t *>(&m_new_root_values[i]),
+            m_chains[i].root_width() });
+    }
+    memory.read_batch(m_requests);
+
+    for (std::size_t i = 0; i != m_chains.size(); ++i) {
+        if (m_resolved[i] && m_new_root_values[i] == m_root_values[i]) continue;
+        m_values[i]      = m_chains[i].walk(memory, m_new_root_values[i]);
+        m_root_values[i] = m_new_root_values[i];
+        m_resolved[i]    = true;
+        ++m_walk_count;
+    }
+}
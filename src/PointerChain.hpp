@@ -0,0 +1,110 @@
+/****************************************************************************
+
+    File: PointerChain.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include "Defs.hpp"
+
+class MemoryReader;
+
+/** A declarative chain of steps from a root value in the target's memory
+ *  to some final value (usually an address).
+ *
+ *  A null (zero) value stays null through offsets and dereferences, so a
+ *  chain whose root is not set up yet resolves to zero.
+ */
+class PointerChain {
+public:
+    /** @param root address of the root value, which is root_width bytes
+     *              (one, two or four) wide
+     */
+    explicit PointerChain(Address root, std::size_t root_width = sizeof(uint32_t));
+
+    /** Keeps only the bits in the mask. */
+    PointerChain & mask(uint32_t);
+
+    /** Adds to the value (if not null). */
+    PointerChain & offset(Address);
+
+    /** Replaces the value by the u32 it points to (if not null). */
+    PointerChain & dereference();
+
+    Address     root()       const noexcept { return m_root; }
+    std::size_t root_width() const noexcept { return m_root_width; }
+
+    bool has_dereferences() const noexcept;
+
+    /** @returns the final value given the root value, reading from memory
+     *           only for dereferences
+     */
+    Address walk(const MemoryReader &, uint32_t root_value) const;
+
+private:
+    enum StepKind { k_mask, k_offset, k_dereference };
+    struct Step {
+        StepKind kind;
+        Address  operand;
+    };
+
+    Address m_root;
+    std::size_t m_root_width;
+    std::vector<Step> m_steps;
+};
+
+/** Resolves registered chains, caching their values: every update reads all
+ *  roots in one batch, and only chains whose root value changed are walked
+ *  again.
+ *
+ *  Pointers a chain dereferences past the root are assumed to change only
+ *  along with the root.
+ */
+class PointerChainResolver {
+public:
+    using ChainId = std::size_t;
+
+    ChainId add(PointerChain);
+
+    /** Re-reads every root, and re-walks chains as needed.
+     *  @throws as MemoryReader::read_batch does
+     */
+    void update(const MemoryReader &);
+
+    /** Forgets all resolved values, the next update walks every chain. */
+    void invalidate() { m_resolved.assign(m_resolved.size(), false); }
+
+    /** @returns the chain's final value, as of the last update */
+    Address value(ChainId id) const { return m_values.at(id); }
+
+    uint32_t root_value(ChainId id) const { return m_root_values.at(id); }
+
+    /** @returns how many chain walks there have been, for profiling */
+    std::size_t walk_count() const noexcept { return m_walk_count; }
+
+private:
+    std::vector<PointerChain> m_chains;
+    std::vector<uint32_t> m_root_values;
+    std::vector<uint32_t> m_new_root_values;
+    std::vector<Address>  m_values;
+    std::vector<bool>     m_resolved;
+    ReadRequestList       m_requests;
+    std::size_t m_walk_count = 0;
+};
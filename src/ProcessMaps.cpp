@@ -0,0 +1,89 @@
+/****************************************************************************
+
+    File: ProcessMaps.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "ProcessMaps.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+#include <cstdlib>
+
+ProcessMapIndex::ProcessMapIndex(int pid):
+    m_path("/proc/" + std::to_string(pid) + "/maps")
+{ refresh(); }
+
+bool ProcessMapIndex::refresh() {
+    m_last_refresh = Clock::now();
+    std::ifstream fin(m_path);
+    m_has_maps = bool(fin);
+    if (!fin) {
+        m_contents.clear();
+    } else {
+        m_contents.assign(std::istreambuf_iterator<char>(fin),
+                          std::istreambuf_iterator<char>());
+    }
+
+    auto count = std::size_t(std::count(m_contents.begin(), m_contents.end(), '\n'));
+    if (count == m_mapping_count && m_contents == m_old_contents) {
+        return false;
+    }
+    m_mapping_count = count;
+    rebuild();
+    m_old_contents.swap(m_contents);
+    return true;
+}
+
+bool ProcessMapIndex::is_readable
+    (Address addr, std::size_t length) const noexcept
+{
+    if (!m_has_maps) return true;
+    auto itr = std::upper_bound(m_readable.begin(), m_readable.end(), addr,
+        [](Address addr, const MemoryRegion & region)
+        { return addr < region.address; });
+    if (itr == m_readable.begin()) return false;
+    --itr;
+    return addr + length <= itr->end();
+}
+
+bool ProcessMapIndex::is_readable_refreshing(Address addr, std::size_t length) {
+    if (is_readable(addr, length)) return true;
+    if (Clock::now() - m_last_refresh < k_min_refresh_interval) return false;
+    return refresh() && is_readable(addr, length);
+}
+
+/* private */ void ProcessMapIndex::rebuild() {
+    // each line looks like:
+    // 08048000-08056000 r-xp 00000000 03:0c 64593   /usr/sbin/gpm
+    m_readable.clear();
+    for_split<is_newline>(m_contents.data(), m_contents.data() + m_contents.size(),
+        [this](const char * beg, const char * end)
+    {
+        char * next = nullptr;
+        auto low = std::strtoull(beg, &next, 16);
+        if (next == end || *next != '-') return;
+        auto high = std::strtoull(next + 1, &next, 16);
+        if (next == end || *next != ' ' || next + 1 == end) return;
+        if (next[1] != 'r' || high <= low) return;
+        m_readable.push_back(MemoryRegion { Address(low), std::size_t(high - low) });
+    });
+    merge_regions(m_readable);
+}
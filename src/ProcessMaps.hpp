@@ -0,0 +1,77 @@
+/****************************************************************************
+
+    File: ProcessMaps.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "Defs.hpp"
+
+#include <chrono>
+
+/** An index of the readable regions of a process, built from
+ *  "/proc/<pid>/maps". Lets readers reject bad addresses up front rather than
+ *  finding out through a failed read.
+ */
+class ProcessMapIndex {
+public:
+    explicit ProcessMapIndex(int pid);
+
+    /** Re-reads the maps file, the index is only rebuilt if the mappings
+     *  actually differ from last time.
+     *  @returns true if the index was rebuilt
+     */
+    bool refresh();
+
+    /** O(log n) lookup of whether all of [addr, addr + length) is readable,
+     *  adjacent readable mappings count as one.
+     *  If the maps file could not be read at all, everything is assumed
+     *  readable (and left to the actual read to fail).
+     */
+    bool is_readable(Address addr, std::size_t length) const noexcept;
+
+    /** Like is_readable, but on a miss the index is refreshed first (no more
+     *  than once every so often, bad pointers tend to come in bursts).
+     */
+    bool is_readable_refreshing(Address addr, std::size_t length);
+
+    /** @returns all readable regions, sorted and merged */
+    const MemoryRegionList & readable_regions() const noexcept
+        { return m_readable; }
+
+    std::size_t mapping_count() const noexcept { return m_mapping_count; }
+
+    bool has_maps() const noexcept { return m_has_maps; }
+
+private:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    static constexpr const auto k_min_refresh_interval = std::chrono::milliseconds(100);
+
+    void rebuild();
+
+    std::string m_path;
+    std::string m_contents;
+    std::string m_old_contents;
+    std::size_t m_mapping_count = 0;
+    bool m_has_maps = false;
+    MemoryRegionList m_readable;
+    TimePoint m_last_refresh;
+};
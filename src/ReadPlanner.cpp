@@ -0,0 +1,167 @@
+/****************************************************************************
+
+    File: ReadPlanner.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "ReadPlanner.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+std::mutex s_totals_mutex;
+ReadPlanStats s_totals;
+
+void add_to_totals(const ReadPlanStats &);
+
+} // end of <anonymous> namespace
+
+ReadPlanStats & ReadPlanStats::operator += (const ReadPlanStats & rhs) noexcept {
+    ranges          += rhs.ranges;
+    reads           += rhs.reads;
+    bytes_requested += rhs.bytes_requested;
+    bytes_over_read += rhs.bytes_over_read;
+    return *this;
+}
+
+// ----------------------------------------------------------------------------
+
+ReadPlanner::Ticket ReadPlanner::add(Address addr, std::size_t length) {
+    if (length == 0) {
+        throw std::invalid_argument("ReadPlanner::add: length must be positive.");
+    }
+    Range range;
+    range.address = addr;
+    range.length  = length;
+    m_ranges.push_back(range);
+    return m_ranges.size() - 1;
+}
+
+ReadStatus ReadPlanner::execute(const MemoryReader & memory) {
+    if (m_ranges.empty()) return ReadStatus::ok;
+    plan_runs();
+
+    if (memory.try_read_batch(m_runs) == ReadStatus::ok) {
+        for (auto & range : m_ranges) range.status = ReadStatus::ok;
+        return ReadStatus::ok;
+    }
+
+    // find out which runs are bad, and then which of their ranges
+    m_run_status.clear();
+    for (const auto & run : m_runs) {
+        m_run_status.push_back(memory.try_read(run.address, run.destination, run.length));
+    }
+    ReadStatus rv = ReadStatus::ok;
+    for (auto idx : m_order) {
+        auto & range = m_ranges[idx];
+        range.status = m_run_status[range.run];
+        if (range.status != ReadStatus::ok && !is_fatal(range.status)) {
+            range.status = memory.try_read(range.address, m_buffer.data() + range.offset,
+                                           range.length);
+        }
+        if (is_fatal(range.status) && !is_fatal(rv)) {
+            rv = range.status;
+        } else if (rv == ReadStatus::ok) {
+            rv = range.status;
+        }
+    }
+    return rv;
+}
+
+const uint8_t * ReadPlanner::data(Ticket ticket) const {
+    const auto & range = m_ranges.at(ticket);
+    if (range.status != ReadStatus::ok) return nullptr;
+    return m_buffer.data() + range.offset;
+}
+
+/* static */ ReadPlanStats ReadPlanner::total_stats() {
+    std::unique_lock<std::mutex> lock(s_totals_mutex);
+    return s_totals;
+}
+
+/* static */ void ReadPlanner::reset_total_stats() {
+    std::unique_lock<std::mutex> lock(s_totals_mutex);
+    s_totals = ReadPlanStats();
+}
+
+void ReadPlanner::clear() noexcept {
+    m_ranges.clear();
+    m_order.clear();
+    m_runs.clear();
+}
+
+/* private */ void ReadPlanner::plan_runs() {
+    m_order.resize(m_ranges.size());
+    std::iota(m_order.begin(), m_order.end(), std::size_t(0));
+    std::sort(m_order.begin(), m_order.end(), [this](std::size_t lhs, std::size_t rhs)
+        { return m_ranges[lhs].address < m_ranges[rhs].address; });
+
+    ReadPlanStats stats;
+    stats.ranges = m_ranges.size();
+
+    // first pass: merge into runs, offsets are relative to the run for now
+    m_runs.clear();
+    Address run_end = 0;
+    std::size_t total = 0;
+    for (auto idx : m_order) {
+        auto & range = m_ranges[idx];
+        range.status = ReadStatus::failed;
+        stats.bytes_requested += range.length;
+        auto range_end = range.address + range.length;
+        if (m_runs.empty() || range.address > run_end + m_gap) {
+            if (!m_runs.empty()) total += m_runs.back().length;
+            m_runs.push_back(ReadRequest { range.address, nullptr, range.length });
+            run_end = range_end;
+        } else if (range_end > run_end) {
+            if (range.address > run_end) stats.bytes_over_read += range.address - run_end;
+            run_end = range_end;
+            m_runs.back().length = run_end - m_runs.back().address;
+        }
+        range.run    = m_runs.size() - 1;
+        range.offset = range.address - m_runs.back().address;
+    }
+    total += m_runs.back().length;
+    stats.reads = m_runs.size();
+
+    // second pass: lay the runs out one after another
+    m_buffer.resize(total);
+    std::size_t offset = 0;
+    for (auto & run : m_runs) {
+        run.destination = m_buffer.data() + offset;
+        offset += run.length;
+    }
+    for (auto & range : m_ranges) {
+        range.offset += std::size_t(m_runs[range.run].destination - m_buffer.data());
+    }
+
+    m_stats += stats;
+    add_to_totals(stats);
+}
+
+namespace {
+
+void add_to_totals(const ReadPlanStats & stats) {
+    std::unique_lock<std::mutex> lock(s_totals_mutex);
+    s_totals += stats;
+}
+
+} // end of <anonymous> namespace
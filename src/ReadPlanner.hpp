@@ -0,0 +1,111 @@
+/****************************************************************************
+
+    File: ReadPlanner.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "MemoryReader.hpp"
+
+struct ReadPlanStats {
+    // ranges asked for, and the reads actually issued for them
+    std::size_t ranges = 0;
+    std::size_t reads  = 0;
+    std::size_t bytes_requested = 0;
+    // bytes read only to bridge gaps between merged ranges
+    std::size_t bytes_over_read = 0;
+
+    std::size_t reads_saved() const noexcept { return ranges - reads; }
+
+    ReadPlanStats & operator += (const ReadPlanStats &) noexcept;
+};
+
+/** Gathers the (address, length) ranges a decode pass needs, then reads them
+ *  all at once: sorted, with overlapping or nearly adjacent ranges (no more
+ *  than the gap threshold apart) merged into single reads. Each range's
+ *  bytes are then available by the ticket add handed out.
+ *
+ *  Reading a little extra between ranges is cheaper than another iovec (or
+ *  another pread), as long as the gap is small.
+ */
+class ReadPlanner {
+public:
+    using Ticket = std::size_t;
+
+    static constexpr const std::size_t k_default_gap = 64;
+
+    explicit ReadPlanner(std::size_t gap_threshold = k_default_gap):
+        m_gap(gap_threshold) {}
+
+    /** @returns ticket for the range, valid until clear */
+    Ticket add(Address, std::size_t length);
+
+    /** Reads every range added since the last clear. A merged read that
+     *  fails is retried range by range, so that one bad range (or a bad
+     *  gap) spoils only itself.
+     *  @returns ok if every range was read, the first fatal status if any,
+     *           otherwise the status of the first range (by address) that
+     *           failed
+     *  @throws only if buffers could not be allocated
+     */
+    ReadStatus execute(const MemoryReader &);
+
+    ReadStatus status(Ticket ticket) const { return m_ranges.at(ticket).status; }
+
+    /** @returns the range's bytes, nullptr if it could not be read */
+    const uint8_t * data(Ticket) const;
+
+    /** Forgets every range, keeping buffers and stats. */
+    void clear() noexcept;
+
+    std::size_t range_count() const noexcept { return m_ranges.size(); }
+
+    /** @returns stats accumulated over every execute */
+    const ReadPlanStats & stats() const noexcept { return m_stats; }
+
+    void reset_stats() noexcept { m_stats = ReadPlanStats(); }
+
+    /** @returns stats accumulated over every execute of every planner (in
+     *           any thread) since the last reset
+     */
+    static ReadPlanStats total_stats();
+
+    static void reset_total_stats();
+
+private:
+    struct Range {
+        Address     address = k_no_address;
+        std::size_t length  = 0;
+        // into m_buffer, shared with whichever ranges it overlaps
+        std::size_t offset  = 0;
+        std::size_t run     = 0;
+        ReadStatus  status  = ReadStatus::failed;
+    };
+
+    void plan_runs();
+
+    std::size_t m_gap;
+    std::vector<Range> m_ranges;
+    std::vector<std::size_t> m_order;
+    // one per merged read
+    ReadRequestList m_runs;
+    std::vector<ReadStatus> m_run_status;
+    std::vector<uint8_t> m_buffer;
+    ReadPlanStats m_stats;
+};
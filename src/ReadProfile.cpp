@@ -0,0 +1,178 @@
+/****************************************************************************
+
+    File: ReadProfile.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "ReadProfile.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+#include <cstdlib>
+
+namespace {
+
+struct SiteRegistry {
+    std::mutex mutex;
+    std::vector<const ReadSite *> sites;
+};
+
+SiteRegistry & site_registry();
+
+const char * read_profile_filename() noexcept;
+
+thread_local ReadSite * t_current_site = nullptr;
+
+} // end of <anonymous> namespace
+
+void LatencyHistogram::add(uint64_t nanoseconds) noexcept {
+    m_buckets[std::size_t(bucket_of(nanoseconds))].fetch_add(1, std::memory_order_relaxed);
+    auto old_max = m_max.load(std::memory_order_relaxed);
+    while (nanoseconds > old_max &&
+           !m_max.compare_exchange_weak(old_max, nanoseconds, std::memory_order_relaxed))
+    {}
+}
+
+uint64_t LatencyHistogram::count() const noexcept {
+    uint64_t rv = 0;
+    for (const auto & bucket : m_buckets) rv += bucket.load(std::memory_order_relaxed);
+    return rv;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const noexcept {
+    auto total = count();
+    if (total == 0) return 0;
+    auto target = uint64_t(fraction*double(total));
+    if (target >= total) target = total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i != k_bucket_count; ++i) {
+        seen += m_buckets[std::size_t(i)].load(std::memory_order_relaxed);
+        if (seen > target) return bucket_upper_bound(i);
+    }
+    return bucket_upper_bound(k_bucket_count - 1);
+}
+
+/* static */ int LatencyHistogram::bucket_of(uint64_t ns) noexcept {
+    if (ns < uint64_t(k_exact_limit)) return int(ns);
+    int exponent = 63 - __builtin_clzll(ns);
+    if (exponent >= k_max_exponent) return k_bucket_count - 1;
+    int sub = int((ns >> (exponent - 3)) & (k_sub_buckets - 1));
+    return k_exact_limit + (exponent - 4)*k_sub_buckets + sub;
+}
+
+/* static */ uint64_t LatencyHistogram::bucket_upper_bound(int bucket) noexcept {
+    if (bucket < k_exact_limit) return uint64_t(bucket);
+    int exponent = 4 + (bucket - k_exact_limit) / k_sub_buckets;
+    int sub      = (bucket - k_exact_limit) % k_sub_buckets;
+    uint64_t width = uint64_t(1) << (exponent - 3);
+    return uint64_t(k_sub_buckets + sub)*width + width - 1;
+}
+
+// ----------------------------------------------------------------------------
+
+ReadSite::ReadSite(const char * name):
+    m_name(name)
+{
+    auto & registry = site_registry();
+    std::unique_lock<std::mutex> lock(registry.mutex);
+    registry.sites.push_back(this);
+}
+
+void ReadSite::record(std::size_t bytes, uint64_t nanoseconds, bool failed) noexcept {
+    m_syscalls.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    if (failed) m_failures.fetch_add(1, std::memory_order_relaxed);
+    m_latencies.add(nanoseconds);
+}
+
+/* static */ ReadSite & ReadSite::current() noexcept
+    { return t_current_site ? *t_current_site : untagged(); }
+
+/* static */ ReadSite & ReadSite::untagged() {
+    static ReadSite inst("untagged");
+    return inst;
+}
+
+/* static */ void ReadSite::for_each(const std::function<void(const ReadSite &)> & f) {
+    std::vector<const ReadSite *> sites;
+    {
+    auto & registry = site_registry();
+    std::unique_lock<std::mutex> lock(registry.mutex);
+    sites = registry.sites;
+    }
+    for (const auto * site : sites) f(*site);
+}
+
+// ----------------------------------------------------------------------------
+
+ReadSiteScope::ReadSiteScope(ReadSite & site) noexcept:
+    m_previous(t_current_site)
+{ t_current_site = &site; }
+
+ReadSiteScope::~ReadSiteScope() { t_current_site = m_previous; }
+
+// ----------------------------------------------------------------------------
+
+bool is_read_profiling() noexcept { return read_profile_filename() != nullptr; }
+
+void dump_read_profile(std::ostream & out) {
+    auto micros = [](uint64_t ns) { return double(ns) / 1000.; };
+    out << std::left << std::setw(20) << "site" << std::right
+        << std::setw(10) << "syscalls" << std::setw(12) << "bytes"
+        << std::setw(8)  << "failed"   << std::setw(10) << "p50 us"
+        << std::setw(10) << "p90 us"   << std::setw(10) << "p99 us"
+        << std::setw(10) << "max us"   << "\n";
+    out << std::fixed << std::setprecision(1);
+    ReadSite::for_each([&out, &micros](const ReadSite & site) {
+        if (site.syscalls() == 0) return;
+        const auto & lat = site.latencies();
+        out << std::left << std::setw(20) << site.name() << std::right
+            << std::setw(10) << site.syscalls() << std::setw(12) << site.bytes()
+            << std::setw(8)  << site.failures()
+            << std::setw(10) << micros(lat.percentile(0.5 ))
+            << std::setw(10) << micros(lat.percentile(0.9 ))
+            << std::setw(10) << micros(lat.percentile(0.99))
+            << std::setw(10) << micros(lat.max()) << "\n";
+    });
+    out << std::flush;
+}
+
+void dump_read_profile() {
+    const char * filename = read_profile_filename();
+    if (!filename) return;
+    std::ofstream fout(filename);
+    dump_read_profile(fout);
+}
+
+namespace {
+
+SiteRegistry & site_registry() {
+    static SiteRegistry inst;
+    return inst;
+}
+
+const char * read_profile_filename() noexcept {
+    // e.g. APIR_READ_PROFILE=reads.txt ./apir
+    static const char * const filename = std::getenv("APIR_READ_PROFILE");
+    return filename;
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,136 @@
+/****************************************************************************
+
+    File: ReadProfile.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <iosfwd>
+
+#include <cstddef>
+#include <cstdint>
+
+/** Latency histogram in the style of HDR histograms: buckets are exact up
+ *  to 16ns, after which each power of two is split into 8 linear
+ *  sub-buckets (so any value is off by no more than 12.5%). Recording is
+ *  lock-free, and may be done from any thread.
+ */
+class LatencyHistogram {
+public:
+    static constexpr const int k_sub_buckets  = 8;
+    static constexpr const int k_exact_limit  = 16;
+    static constexpr const int k_max_exponent = 40;
+    static constexpr const int k_bucket_count =
+        k_exact_limit + (k_max_exponent - 4)*k_sub_buckets;
+
+    void add(uint64_t nanoseconds) noexcept;
+
+    uint64_t count() const noexcept;
+
+    /** @param fraction in [0 1], e.g. 0.99 for the 99th percentile
+     *  @returns upper bound of the bucket the percentile falls in, zero if
+     *           nothing was recorded
+     */
+    uint64_t percentile(double fraction) const noexcept;
+
+    uint64_t max() const noexcept { return m_max.load(std::memory_order_relaxed); }
+
+    static int bucket_of(uint64_t nanoseconds) noexcept;
+
+    /** @returns largest value that falls into the bucket */
+    static uint64_t bucket_upper_bound(int bucket) noexcept;
+
+private:
+    std::array<std::atomic<uint64_t>, k_bucket_count> m_buckets {};
+    std::atomic<uint64_t> m_max { 0 };
+};
+
+/** A place in the code reads are made from. Each read syscall is
+ *  attributed to whichever site the calling thread is in (see
+ *  ReadSiteScope), or to the untagged site if none.
+ *
+ *  Sites must outlive every read, so are meant to be function local
+ *  statics, e.g.:
+ *  static ReadSite s_site("bank pointers");
+ *  ReadSiteScope scope(s_site);
+ */
+class ReadSite {
+public:
+    explicit ReadSite(const char * name);
+
+    ReadSite(const ReadSite &) = delete;
+    ReadSite & operator = (const ReadSite &) = delete;
+
+    const char * name() const noexcept { return m_name; }
+
+    void record(std::size_t bytes, uint64_t nanoseconds, bool failed) noexcept;
+
+    uint64_t syscalls() const noexcept { return m_syscalls.load(std::memory_order_relaxed); }
+    uint64_t bytes   () const noexcept { return m_bytes   .load(std::memory_order_relaxed); }
+    uint64_t failures() const noexcept { return m_failures.load(std::memory_order_relaxed); }
+
+    const LatencyHistogram & latencies() const noexcept { return m_latencies; }
+
+    /** @returns the site the calling thread is in */
+    static ReadSite & current() noexcept;
+
+    static ReadSite & untagged();
+
+    /** Calls f for every site, in the order they were first used. */
+    static void for_each(const std::function<void(const ReadSite &)> &);
+
+private:
+    friend class ReadSiteScope;
+
+    const char * m_name;
+    std::atomic<uint64_t> m_syscalls { 0 };
+    std::atomic<uint64_t> m_bytes    { 0 };
+    std::atomic<uint64_t> m_failures { 0 };
+    LatencyHistogram m_latencies;
+};
+
+/** Attributes the calling thread's reads to a site, until the scope ends
+ *  (scopes nest, the innermost wins).
+ */
+class ReadSiteScope {
+public:
+    explicit ReadSiteScope(ReadSite &) noexcept;
+
+    ReadSiteScope(const ReadSiteScope &) = delete;
+    ReadSiteScope & operator = (const ReadSiteScope &) = delete;
+
+    ~ReadSiteScope();
+
+private:
+    ReadSite * m_previous;
+};
+
+/** @returns true if reads are being profiled, which is when
+ *           APIR_READ_PROFILE names a file to dump the profile to
+ */
+bool is_read_profiling() noexcept;
+
+/** Writes a table of every site's syscalls, bytes and latency percentiles. */
+void dump_read_profile(std::ostream &);
+
+/** Writes the profile to the file APIR_READ_PROFILE names, if profiling. */
+void dump_read_profile();
@@ -0,0 +1,254 @@
+/****************************************************************************
+
+    File: RecordingMemoryReader.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include "RecordingMemoryReader.hpp"
+
+#include <iterator>
+#include <algorithm>
+
+namespace {
+
+using Error = std::runtime_error;
+
+[[noreturn]] void throw_status(const char * who, Address, ReadStatus);
+
+} // end of <anonymous> namespace
+
+RecordingMemoryReader::RecordingMemoryReader
+    (std::shared_ptr<const MemoryReader> source, const std::string & filename):
+    m_source(std::move(source)),
+    m_start(Clock::now()),
+    m_out(filename, std::ios::binary | std::ios::trunc)
+{
+    using namespace RecordingFormat;
+    if (!m_source) {
+        throw std::invalid_argument("RecordingMemoryReader::RecordingMemoryReader: "
+                                    "source must not be null.");
+    }
+    if (!m_out) {
+        throw Error("RecordingMemoryReader: cannot open \"" + filename + "\" for writing.");
+    }
+    Header header {};
+    std::copy(k_magic, k_magic + k_magic_size, header.magic);
+    header.version = k_version;
+    m_out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+}
+
+void RecordingMemoryReader::read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const
+{
+    auto status = m_source->try_read(addr, buf, bytes_in_buf);
+    log(addr, buf, bytes_in_buf, status);
+    if (status != ReadStatus::ok) {
+        throw_status("RecordingMemoryReader::read", addr, status);
+    }
+}
+
+void RecordingMemoryReader::read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const
+{
+    if (try_read_batch(beg, end) == ReadStatus::ok) return;
+    // throws from the first request which failed
+    for (auto itr = beg; itr != end; ++itr) {
+        read(itr->address, itr->destination, itr->length);
+    }
+}
+
+ReadStatus RecordingMemoryReader::try_read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept
+{
+    auto status = m_source->try_read(addr, buf, bytes_in_buf);
+    log(addr, buf, bytes_in_buf, status);
+    return status;
+}
+
+ReadStatus RecordingMemoryReader::try_read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const noexcept
+{
+    auto status = m_source->try_read_batch(beg, end);
+    if (status != ReadStatus::ok) {
+        // which requests failed isn't known, so none are logged (the
+        // caller's fallback reads are)
+        return status;
+    }
+    for (auto itr = beg; itr != end; ++itr) {
+        log(itr->address, itr->destination, itr->length, ReadStatus::ok);
+    }
+    return status;
+}
+
+void RecordingMemoryReader::describe_source(std::ostream & out) const {
+    out << "recording of ";
+    m_source->describe_source(out);
+}
+
+/* private */ void RecordingMemoryReader::log
+    (Address addr, const uint8_t * buf, std::size_t length, ReadStatus status) const noexcept
+{
+    using namespace RecordingFormat;
+    std::array<char, k_entry_header_size> header;
+    double   timestamp = std::chrono::duration<double>(Clock::now() - m_start).count();
+    uint64_t address   = addr;
+    uint32_t length32  = uint32_t(length);
+    uint8_t  status8   = uint8_t(status);
+    auto * itr = header.data();
+    auto put = [&itr](const auto & obj) {
+        std::memcpy(itr, &obj, sizeof(obj));
+        itr += sizeof(obj);
+    };
+    put(timestamp);
+    put(address);
+    put(length32);
+    put(status8);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_out.write(header.data(), std::streamsize(header.size()));
+    if (status == ReadStatus::ok) {
+        m_out.write(reinterpret_cast<const char *>(buf), std::streamsize(length));
+    }
+    ++m_entry_count;
+}
+
+// ----------------------------------------------------------------------------
+
+ReplayMemoryReader::ReplayMemoryReader(const std::string & filename, double speed):
+    m_filename(filename),
+    m_speed(speed),
+    m_start(Clock::now())
+{
+    using namespace RecordingFormat;
+    if (!(speed >= 0.)) {
+        throw std::invalid_argument("ReplayMemoryReader::ReplayMemoryReader: "
+                                    "speed must be a non-negative number.");
+    }
+    std::ifstream fin(filename, std::ios::binary);
+    if (!fin) {
+        throw Error("ReplayMemoryReader: cannot open \"" + filename + "\".");
+    }
+    std::vector<char> contents((std::istreambuf_iterator<char>(fin)),
+                               std::istreambuf_iterator<char>());
+    Header header;
+    if (contents.size() < sizeof(Header)) {
+        throw Error("ReplayMemoryReader: \"" + filename + "\" is too small to be a recording.");
+    }
+    std::memcpy(&header, contents.data(), sizeof(Header));
+    if (!std::equal(k_magic, k_magic + k_magic_size, header.magic)) {
+        throw Error("ReplayMemoryReader: \"" + filename + "\" is not a recording.");
+    }
+    if (header.version != k_version) {
+        throw Error("ReplayMemoryReader: \"" + filename + "\" is of an unsupported version.");
+    }
+
+    const char * itr = contents.data() + sizeof(Header);
+    const char * end = contents.data() + contents.size();
+    auto get = [&itr](auto & obj) {
+        std::memcpy(&obj, itr, sizeof(obj));
+        itr += sizeof(obj);
+    };
+    m_bytes.reserve(contents.size());
+    while (end - itr >= std::ptrdiff_t(k_entry_header_size)) {
+        double   timestamp;
+        uint64_t address;
+        uint32_t length;
+        uint8_t  status;
+        get(timestamp);
+        get(address);
+        get(length);
+        get(status);
+        Entry entry { timestamp, ReadStatus(status), m_bytes.size() };
+        if (entry.status == ReadStatus::ok) {
+            // a truncated recording (say the session was killed) is fine
+            if (end - itr < std::ptrdiff_t(length)) break;
+            m_bytes.insert(m_bytes.end(), itr, itr + length);
+            itr += length;
+        }
+        m_entries[Key(Address(address), length)].push_back(entry);
+        m_duration = std::max(m_duration, timestamp);
+        ++m_entry_count;
+    }
+}
+
+void ReplayMemoryReader::read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const
+{
+    auto status = try_read(addr, buf, bytes_in_buf);
+    if (status != ReadStatus::ok) {
+        throw_status("ReplayMemoryReader::read", addr, status);
+    }
+}
+
+ReadStatus ReplayMemoryReader::try_read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept
+{
+    auto itr = m_entries.find(Key(addr, bytes_in_buf));
+    if (itr == m_entries.end()) return ReadStatus::bad_address;
+    const auto & entries = itr->second;
+    // latest entry no later than now (or the first, if it's not yet time
+    // for any of them)
+    auto t = now();
+    auto eitr = std::upper_bound(entries.begin(), entries.end(), t,
+        [](double t, const Entry & entry) { return t < entry.timestamp; });
+    if (eitr != entries.begin()) --eitr;
+    if (eitr->status != ReadStatus::ok) return eitr->status;
+    std::copy_n(m_bytes.data() + eitr->offset, bytes_in_buf, buf);
+    return ReadStatus::ok;
+}
+
+ReadStatus ReplayMemoryReader::try_read_batch
+    (const ReadRequest * beg, const ReadRequest * end) const noexcept
+{
+    // request by request, a read missing from the recording is an ordinary
+    // outcome here and shouldn't cost a throw
+    for (auto itr = beg; itr != end; ++itr) {
+        auto status = try_read(itr->address, itr->destination, itr->length);
+        if (status != ReadStatus::ok) return status;
+    }
+    return ReadStatus::ok;
+}
+
+void ReplayMemoryReader::describe_source(std::ostream & out) const
+    { out << "replay of \"" << m_filename << "\""; }
+
+void ReplayMemoryReader::advance_to(double seconds) {
+    if (seconds < m_manual_time.load()) {
+        throw std::invalid_argument("ReplayMemoryReader::advance_to: time may "
+                                    "not go backwards.");
+    }
+    m_manual_time.store(seconds);
+}
+
+double ReplayMemoryReader::now() const noexcept {
+    if (m_speed == 0.) return m_manual_time.load();
+    return std::chrono::duration<double>(Clock::now() - m_start).count()*m_speed;
+}
+
+namespace {
+
+[[noreturn]] void throw_status(const char * who, Address addr, ReadStatus status) {
+    if (status == ReadStatus::no_permission) {
+        throw PermissionError("Lost permission to read the target's memory.");
+    }
+    throw Error(std::string(who) + ": failed to read at address "
+                + std::to_string(addr) + ".");
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,159 @@
+/****************************************************************************
+
+    File: RecordingMemoryReader.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include "MemoryReader.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+/** Recordings log every read a session makes, so the session can be played
+ *  back later without a live game (for benchmarks and regression tests).
+ *
+ *  Layout (all integers in the writing machine's byte order):
+ *  - header: 8 byte magic "APIRRECD", u32 version, u32 reserved
+ *  - entries, one per read, until the end of the file: f64 timestamp
+ *    (seconds since recording started), u64 address, u32 length, u8 status
+ *    (a ReadStatus), then length bytes if the status is ok
+ */
+namespace RecordingFormat {
+
+constexpr const char     k_magic[] = "APIRRECD";
+constexpr const int      k_magic_size = 8;
+constexpr const uint32_t k_version = 1;
+
+struct Header {
+    char     magic[k_magic_size];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+// entries are packed, not written as a struct
+constexpr const std::size_t k_entry_header_size =
+    sizeof(double) + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint8_t);
+
+} // end of RecordingFormat namespace
+
+/** Passes reads through to its source, logging each one (failures too) to a
+ *  recording file. Safe to share between threads if the source is.
+ */
+class RecordingMemoryReader final : public MemoryReader {
+public:
+    RecordingMemoryReader(std::shared_ptr<const MemoryReader>, const std::string & filename);
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    using MemoryReader::read_batch;
+    void read_batch(const ReadRequest * beg, const ReadRequest * end) const override;
+
+    ReadStatus try_read(Address, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override;
+
+    using MemoryReader::try_read_batch;
+    ReadStatus try_read_batch(const ReadRequest * beg, const ReadRequest * end) const noexcept override;
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return m_source->is_readable(addr, length); }
+
+    void describe_source(std::ostream &) const override;
+
+    std::size_t entry_count() const noexcept { return m_entry_count; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void log(Address, const uint8_t *, std::size_t, ReadStatus) const noexcept;
+
+    std::shared_ptr<const MemoryReader> m_source;
+    Clock::time_point m_start;
+
+    mutable std::mutex    m_mutex;
+    mutable std::ofstream m_out;
+    mutable std::size_t   m_entry_count = 0;
+};
+
+/** Plays back a recording: a read is answered with the most recent recorded
+ *  read of the same address and length, as of the replay's clock. Reads
+ *  never recorded fail as bad addresses.
+ *
+ *  The clock either follows real time (scaled by speed, so speed 10 plays
+ *  back ten times as fast), or with a speed of zero only moves by
+ *  advance_to, for fully deterministic runs.
+ */
+class ReplayMemoryReader final : public MemoryReader {
+public:
+    explicit ReplayMemoryReader(const std::string & filename, double speed = 1.);
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    ReadStatus try_read(Address, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override;
+
+    using MemoryReader::try_read_batch;
+    ReadStatus try_read_batch(const ReadRequest * beg, const ReadRequest * end) const noexcept override;
+
+    void describe_source(std::ostream &) const override;
+
+    /** Only meaningful for a replay with a speed of zero.
+     *  @param seconds time in the recording, must not go backwards
+     */
+    void advance_to(double seconds);
+
+    /** @returns the current time in the recording */
+    double now() const noexcept;
+
+    /** @returns timestamp of the last entry */
+    double duration() const noexcept { return m_duration; }
+
+    bool finished() const noexcept { return now() >= m_duration; }
+
+    std::size_t entry_count() const noexcept { return m_entry_count; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        double      timestamp;
+        ReadStatus  status;
+        std::size_t offset; // into m_bytes
+    };
+
+    struct KeyHash {
+        std::size_t operator () (const std::pair<Address, std::size_t> & key) const noexcept
+            { return std::hash<Address>()(key.first) ^ (std::hash<std::size_t>()(key.second) << 1); }
+    };
+
+    using Key = std::pair<Address, std::size_t>;
+
+    std::string m_filename;
+    double m_speed;
+    Clock::time_point m_start;
+    std::atomic<double> m_manual_time { 0. };
+    double m_duration = 0.;
+    std::size_t m_entry_count = 0;
+
+    std::vector<uint8_t> m_bytes;
+    // every entry for an address and length, in recorded order
+    std::unordered_map<Key, std::vector<Entry>, KeyHash> m_entries;
+};
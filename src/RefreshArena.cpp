@@ -0,0 +1,56 @@
+/****************************************************************************
+
+    File: RefreshArena.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "RefreshArena.hpp"
+
+#include <algorithm>
+
+RefreshArena::RefreshArena(std::size_t initial_capacity):
+    m_block(new unsigned char[std::max(initial_capacity, std::size_t(1))]),
+    m_capacity(std::max(initial_capacity, std::size_t(1)))
+{}
+
+void RefreshArena::reset() {
+    if (!m_overflow.empty()) {
+        // everything from this refresh in one block, with room to spare
+        auto capacity = std::max(m_capacity*2, m_used + m_overflow_bytes);
+        m_block.reset(new unsigned char[capacity]);
+        m_capacity = capacity;
+        m_overflow.clear();
+        m_overflow_bytes = 0;
+    }
+    m_used = 0;
+}
+
+/* private */ void * RefreshArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    void * ptr = m_block.get() + m_used;
+    std::size_t space = m_capacity - m_used;
+    if (std::align(alignment, bytes, ptr, space)) {
+        m_used = m_capacity - space + bytes;
+        return ptr;
+    }
+    // doesn't fit until the next reset
+    m_overflow.emplace_back(new unsigned char[bytes + alignment]);
+    m_overflow_bytes += bytes + alignment;
+    ptr = m_overflow.back().get();
+    space = bytes + alignment;
+    return std::align(alignment, bytes, ptr, space);
+}
@@ -0,0 +1,75 @@
+/****************************************************************************
+
+    File: RefreshArena.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+/** A monotonic arena for everything built during one refresh, released all
+ *  at once by reset() rather than freed piece by piece. Each refresh starts
+ *  from one block, which reset() grows to fit the largest refresh so far, so
+ *  that once warmed up refreshes make no heap allocations at all.
+ *
+ *  Deallocation does nothing, memory is only ever reclaimed by reset().
+ *  Not thread safe.
+ */
+class RefreshArena final : public std::pmr::memory_resource {
+public:
+    static constexpr const std::size_t k_default_capacity = 4096;
+
+    explicit RefreshArena(std::size_t initial_capacity = k_default_capacity);
+
+    RefreshArena(const RefreshArena &) = delete;
+    RefreshArena & operator = (const RefreshArena &) = delete;
+
+    /** Releases everything allocated since the last reset, nothing allocated
+     *  from the arena may be used afterwards.
+     */
+    void reset();
+
+    /** @returns size of the block each refresh starts from */
+    std::size_t capacity() const noexcept { return m_capacity; }
+
+    /** @returns bytes handed out since the last reset (including padding
+     *           for alignment)
+     */
+    std::size_t bytes_used() const noexcept { return m_used + m_overflow_bytes; }
+
+private:
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource & rhs) const noexcept override
+        { return this == &rhs; }
+
+    using Block = std::unique_ptr<unsigned char[]>;
+
+    Block m_block;
+    std::size_t m_capacity;
+    std::size_t m_used = 0;
+
+    // allocations which did not fit, freed (and the block grown) on reset
+    std::vector<Block> m_overflow;
+    std::size_t m_overflow_bytes = 0;
+};
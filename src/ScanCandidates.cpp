@@ -0,0 +1,278 @@
+/****************************************************************************
+
+    File: ScanCandidates.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include "ScanCandidates.hpp"
+#include "MemoryReader.hpp"
+#include "ReadProfile.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include <cmath>
+
+namespace {
+
+/** @throws std::invalid_argument if x is not finite (or negative, for a
+ *          magnitude)
+ */
+NarrowPass make_pass(NarrowPass::Kind, double x, bool is_magnitude);
+
+template <typename T>
+bool operand_fits(double x) noexcept;
+
+/** @returns true if the candidate's new value passes */
+bool passes(ScanValue::Type, const NarrowPass &, const uint8_t * old_value, const uint8_t * new_value);
+
+/** A missing target or permission says nothing about any one candidate.
+ *  @throws PermissionError or std::runtime_error
+ */
+[[noreturn]] void throw_fatal(ReadStatus);
+
+} // end of <anonymous> namespace
+
+/* static */ NarrowPass NarrowPass::increased_by(double x)
+    { return make_pass(k_increased_by, x, true); }
+
+/* static */ NarrowPass NarrowPass::decreased_by(double x)
+    { return make_pass(k_decreased_by, x, true); }
+
+/* static */ NarrowPass NarrowPass::equals(double x)
+    { return make_pass(k_equals, x, false); }
+
+bool NarrowPass::fits(ScanValue::Type type) const noexcept {
+    switch (type) {
+    case ScanValue::k_u8 : return operand_fits<uint8_t >(operand);
+    case ScanValue::k_u16: return operand_fits<uint16_t>(operand);
+    case ScanValue::k_u32: return operand_fits<uint32_t>(operand);
+    case ScanValue::k_f32: return operand_fits<float   >(operand);
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+CompactAddressSet::ConstIterator & CompactAddressSet::ConstIterator::operator ++ () {
+    m_itr = m_next;
+    if (m_itr == m_end) return *this;
+    // LEB128 style, seven bits per byte, high bit set on all but the last
+    Address delta = 0;
+    int shift = 0;
+    for (m_next = m_itr; *m_next & 0x80; ++m_next, shift += 7) {
+        delta |= Address(*m_next & 0x7F) << shift;
+    }
+    delta |= Address(*m_next++) << shift;
+    m_address += delta;
+    return *this;
+}
+
+/* private */ CompactAddressSet::ConstIterator::ConstIterator
+    (const uint8_t * itr, const uint8_t * end):
+    m_next(itr),
+    m_end(end)
+{ ++(*this); }
+
+void CompactAddressSet::append(Address addr) {
+    if (m_count != 0 && addr <= m_last) {
+        throw std::invalid_argument("CompactAddressSet::append: addresses must "
+                                    "be appended in ascending order.");
+    }
+    // the first delta is from zero
+    auto delta = addr - m_last;
+    for (; delta >= 0x80; delta >>= 7) {
+        m_bytes.push_back(uint8_t(delta & 0x7F) | 0x80);
+    }
+    m_bytes.push_back(uint8_t(delta));
+    m_last = addr;
+    ++m_count;
+}
+
+void CompactAddressSet::clear() {
+    m_bytes.clear();
+    m_count = 0;
+    m_last  = 0;
+}
+
+// ----------------------------------------------------------------------------
+
+ScanCandidates::ScanCandidates(ScanValue::Type type_):
+    m_type(type_)
+{}
+
+void ScanCandidates::clear() {
+    m_addresses.clear();
+    m_values.clear();
+}
+
+void ScanCandidates::record(Address addr, const uint8_t * value, std::size_t length) {
+    if (length != width()) {
+        throw std::invalid_argument("ScanCandidates::record: value's length "
+                                    "must match the candidates' value type.");
+    }
+    m_addresses.append(addr);
+    m_values.insert(m_values.end(), value, value + length);
+}
+
+void ScanCandidates::narrow(const MemoryReader & memory, const NarrowPass & pass) {
+    if (!pass.fits(m_type)) {
+        throw std::invalid_argument("ScanCandidates::narrow: pass' operand does "
+                                    "not fit the candidates' value type.");
+    }
+    static ReadSite s_site("scan narrowing");
+    ReadSiteScope scope(s_site);
+    const auto width = this->width();
+    CompactAddressSet kept;
+    std::vector<uint8_t> kept_values;
+
+    // per batch: candidates close together are read as one run
+    std::vector<Address>     batch;
+    std::vector<std::size_t> run_of;
+    std::vector<uint8_t>     buffer;
+    ReadRequestList          runs;
+    std::vector<bool>        readable;
+    batch .reserve(k_addresses_per_batch);
+    run_of.reserve(k_addresses_per_batch);
+    const uint8_t * old_values = m_values.data();
+
+    auto finish_batch = [&]() {
+        runs.clear();
+        run_of.clear();
+        for (auto addr : batch) {
+            if (runs.empty() || addr > runs.back().address + runs.back().length + k_max_read_gap) {
+                runs.push_back(ReadRequest { addr, nullptr, width });
+            } else {
+                runs.back().length = addr + width - runs.back().address;
+            }
+            run_of.push_back(runs.size() - 1);
+        }
+        std::size_t total = 0;
+        for (const auto & run : runs) total += run.length;
+        buffer.resize(total);
+        auto * dest = buffer.data();
+        for (auto & run : runs) {
+            run.destination = dest;
+            dest += run.length;
+        }
+
+        readable.assign(runs.size(), true);
+        auto status = memory.try_read_batch(runs);
+        if (is_fatal(status)) throw_fatal(status);
+        if (status != ReadStatus::ok) {
+            // find out which runs spoiled the batch
+            for (std::size_t i = 0; i != runs.size(); ++i) {
+                const auto & run = runs[i];
+                status = memory.try_read(run.address, run.destination, run.length);
+                if (is_fatal(status)) throw_fatal(status);
+                readable[i] = status == ReadStatus::ok;
+            }
+        }
+
+        for (std::size_t i = 0; i != batch.size(); ++i) {
+            const auto * old_value = old_values + i*width;
+            const auto & run = runs[run_of[i]];
+            if (!readable[run_of[i]]) continue;
+            const auto * new_value = run.destination + (batch[i] - run.address);
+            if (!passes(m_type, pass, old_value, new_value)) continue;
+            kept.append(batch[i]);
+            kept_values.insert(kept_values.end(), new_value, new_value + width);
+        }
+        old_values += batch.size()*width;
+        batch.clear();
+    };
+
+    for (auto addr : m_addresses) {
+        batch.push_back(addr);
+        if (batch.size() == k_addresses_per_batch) finish_batch();
+    }
+    if (!batch.empty()) finish_batch();
+
+    kept.shrink_to_fit();
+    kept_values.shrink_to_fit();
+    m_addresses = std::move(kept);
+    m_values.swap(kept_values);
+}
+
+namespace {
+
+NarrowPass make_pass(NarrowPass::Kind kind, double x, bool is_magnitude) {
+    if (!std::isfinite(x)) {
+        throw std::invalid_argument("NarrowPass: operand must be finite.");
+    }
+    if (is_magnitude && x < 0.) {
+        throw std::invalid_argument("NarrowPass: operand is how much the value "
+                                    "moved, and must not be negative.");
+    }
+    return NarrowPass { kind, x };
+}
+
+template <typename T>
+bool operand_fits(double x) noexcept {
+    if (!std::isfinite(x)) return false;
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::abs(x) <= double(std::numeric_limits<T>::max());
+    } else {
+        return    x >= double(std::numeric_limits<T>::min())
+               && x <= double(std::numeric_limits<T>::max())
+               && x == std::floor(x);
+    }
+}
+
+template <typename T>
+bool passes(const NarrowPass & pass, const uint8_t * old_value, const uint8_t * new_value) {
+    T old_, new_;
+    std::memcpy(&old_, old_value, sizeof(T));
+    std::memcpy(&new_, new_value, sizeof(T));
+    // the pass fits T (see narrow), for the "by" passes the operand is a
+    // magnitude, so unsigned values wrap as they do in the target
+    auto operand = T(pass.operand);
+    switch (pass.kind) {
+    // changes are by bit pattern (so a float NaN is "unchanged")
+    case NarrowPass::k_changed  : return std::memcmp(old_value, new_value, sizeof(T)) != 0;
+    case NarrowPass::k_unchanged: return std::memcmp(old_value, new_value, sizeof(T)) == 0;
+    case NarrowPass::k_increased_by: return new_ == T(old_ + operand);
+    case NarrowPass::k_decreased_by: return new_ == T(old_ - operand);
+    case NarrowPass::k_equals      : return new_ == operand;
+    }
+    return false;
+}
+
+bool passes
+    (ScanValue::Type type, const NarrowPass & pass,
+     const uint8_t * old_value, const uint8_t * new_value)
+{
+    switch (type) {
+    case ScanValue::k_u8 : return passes<uint8_t >(pass, old_value, new_value);
+    case ScanValue::k_u16: return passes<uint16_t>(pass, old_value, new_value);
+    case ScanValue::k_u32: return passes<uint32_t>(pass, old_value, new_value);
+    case ScanValue::k_f32: return passes<float   >(pass, old_value, new_value);
+    }
+    return false;
+}
+
+[[noreturn]] void throw_fatal(ReadStatus status) {
+    if (status == ReadStatus::no_permission) {
+        throw PermissionError("Lost permission to read the target's memory.");
+    }
+    throw std::runtime_error("Target process is no longer readable.");
+}
+
+} // end of <anonymous> namespace
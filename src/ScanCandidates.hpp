@@ -0,0 +1,178 @@
+/****************************************************************************
+
+    File: ScanCandidates.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include "MemoryScanner.hpp"
+
+#include <iterator>
+
+/** A sorted set of addresses, stored as varint encoded deltas. Hits from a
+ *  scan sit close together, so most take a byte or two rather than eight.
+ *  Addresses must be appended in ascending order, and can only be walked
+ *  from the front.
+ */
+class CompactAddressSet {
+public:
+    class ConstIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = Address;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const Address *;
+        using reference         = const Address &;
+
+        ConstIterator() {}
+
+        const Address & operator * () const noexcept { return m_address; }
+
+        ConstIterator & operator ++ ();
+        ConstIterator operator ++ (int) { auto t = *this; ++(*this); return t; }
+
+        bool operator == (const ConstIterator & rhs) const noexcept
+            { return m_itr == rhs.m_itr; }
+        bool operator != (const ConstIterator & rhs) const noexcept
+            { return m_itr != rhs.m_itr; }
+
+    private:
+        friend class CompactAddressSet;
+        ConstIterator(const uint8_t * itr, const uint8_t * end);
+
+        const uint8_t * m_itr  = nullptr;
+        const uint8_t * m_next = nullptr;
+        const uint8_t * m_end  = nullptr;
+        Address m_address = 0;
+    };
+
+    /** @throws if addr is not greater than the last address appended */
+    void append(Address addr);
+
+    void clear();
+
+    void shrink_to_fit() { m_bytes.shrink_to_fit(); }
+
+    std::size_t size() const noexcept { return m_count; }
+
+    bool empty() const noexcept { return m_count == 0; }
+
+    std::size_t bytes_used() const noexcept { return m_bytes.capacity(); }
+
+    ConstIterator begin() const
+        { return ConstIterator(m_bytes.data(), m_bytes.data() + m_bytes.size()); }
+
+    ConstIterator end() const
+        { return ConstIterator(m_bytes.data() + m_bytes.size(), m_bytes.data() + m_bytes.size()); }
+
+private:
+    std::vector<uint8_t> m_bytes;
+    std::size_t m_count = 0;
+    Address m_last = 0;
+};
+
+/** A narrowing pass, compares what's in memory now against what each
+ *  candidate held last time.
+ */
+struct NarrowPass {
+    enum Kind { k_changed, k_unchanged, k_increased_by, k_decreased_by, k_equals };
+
+    static NarrowPass changed  () { return NarrowPass { k_changed  , 0. }; }
+    static NarrowPass unchanged() { return NarrowPass { k_unchanged, 0. }; }
+
+    /** @throws std::invalid_argument if x is not finite, or is negative for
+     *          the "by" passes (x is how much the value moved)
+     */
+    static NarrowPass increased_by(double x);
+    static NarrowPass decreased_by(double x);
+    static NarrowPass equals      (double x);
+
+    /** @returns true if the operand can be held by the given value type
+     *           exactly (integer types hold only whole numbers in range)
+     */
+    bool fits(ScanValue::Type) const noexcept;
+
+    Kind   kind;
+    // converted to the candidates' value type before comparing
+    double operand;
+};
+
+/** Candidates (address and last seen value) from a first scan, which
+ *  narrowing passes then whittle down. Record a scan straight into it.
+ */
+class ScanCandidates final : public MemoryRecorder {
+public:
+    // candidates closer than this are read together
+    static constexpr const std::size_t k_max_read_gap        = 64;
+    static constexpr const std::size_t k_addresses_per_batch = 4096;
+
+    explicit ScanCandidates(ScanValue::Type);
+
+    void clear() override;
+
+    /** Candidates must be recorded in ascending address order (as the scanner
+     *  does).
+     */
+    void record(Address, const uint8_t *, std::size_t) override;
+
+    int results_count() const override { return int(size()); }
+
+    /** Re-reads only the surviving candidates (in batches), keeping those
+     *  which pass and their new values. Unreadable candidates are dropped.
+     *  @throws std::invalid_argument if the pass' operand does not fit the
+     *          candidates' value type (nothing is read or dropped)
+     *  @throws PermissionError or std::runtime_error if the target can't be
+     *          read at all anymore (the candidates are left as they were)
+     */
+    void narrow(const MemoryReader &, const NarrowPass &);
+
+    std::size_t size() const noexcept { return m_addresses.size(); }
+
+    /** @returns bytes held for the addresses and their values */
+    std::size_t bytes_used() const noexcept
+        { return m_addresses.bytes_used() + m_values.capacity(); }
+
+    ScanValue::Type type() const noexcept { return m_type; }
+
+    const CompactAddressSet & addresses() const noexcept { return m_addresses; }
+
+    /** Calls f(Address, const uint8_t * value) for each candidate, in order. */
+    template <typename Func>
+    void for_each(Func && f) const;
+
+private:
+    std::size_t width() const noexcept { return ScanValue::width_of(m_type); }
+
+    ScanValue::Type m_type;
+    CompactAddressSet m_addresses;
+    // width bytes per candidate, in the same order as the addresses
+    std::vector<uint8_t> m_values;
+};
+
+// ----------------------------------------------------------------------------
+
+template <typename Func>
+void ScanCandidates::for_each(Func && f) const {
+    const uint8_t * value = m_values.data();
+    for (auto addr : m_addresses) {
+        f(addr, value);
+        value += width();
+    }
+}
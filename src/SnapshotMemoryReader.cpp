@@ -0,0 +1,266 @@
+/****************************************************************************
+
+    File: SnapshotMemoryReader.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "SnapshotMemoryReader.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+using Error = std::runtime_error;
+
+template <typename T>
+void write_pod(std::ostream & out, const T & obj)
+    { out.write(reinterpret_cast<const char *>(&obj), sizeof(T)); }
+
+} // end of <anonymous> namespace
+
+void write_snapshot
+    (const std::string & filename, const MemoryReader & source, MemoryRegionList regions)
+{
+    using namespace SnapshotFormat;
+    merge_regions(regions);
+
+    std::size_t total = 0;
+    for (const auto & region : regions) total += region.length;
+
+    // read everything first, a snapshot should capture a single moment
+    std::vector<uint8_t> data(total);
+    ReadRequestList requests;
+    requests.reserve(regions.size());
+    auto * dest = data.data();
+    for (const auto & region : regions) {
+        requests.push_back(ReadRequest { region.address, dest, region.length });
+        dest += region.length;
+    }
+    source.read_batch(requests);
+
+    std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+    if (!fout) {
+        throw Error("write_snapshot: cannot open \"" + filename + "\" for writing.");
+    }
+
+    Header header {};
+    std::copy(k_magic, k_magic + k_magic_size, header.magic);
+    header.version       = k_version;
+    header.segment_count = uint32_t(regions.size());
+    write_pod(fout, header);
+
+    uint64_t offset = sizeof(Header) + sizeof(Segment)*regions.size();
+    for (const auto & region : regions) {
+        write_pod(fout, Segment { region.address, region.length, offset });
+        offset += region.length;
+    }
+    fout.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+    if (!fout) {
+        throw Error("write_snapshot: failed while writing \"" + filename + "\".");
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+SnapshotMemoryReader::SnapshotMemoryReader(const std::string & filename):
+    m_filename(filename)
+{
+    using namespace SnapshotFormat;
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw Error("SnapshotMemoryReader: cannot open \"" + filename + "\".");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(Header)) {
+        (void)close(fd);
+        throw Error("SnapshotMemoryReader: \"" + filename + "\" is too small to be a snapshot.");
+    }
+    m_map_size = std::size_t(st.st_size);
+    void * map = mmap(nullptr, m_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping stays valid once the descriptor is closed
+    (void)close(fd);
+    if (map == MAP_FAILED) {
+        throw Error("SnapshotMemoryReader: cannot map \"" + filename + "\".");
+    }
+    m_map = static_cast<const uint8_t *>(map);
+
+    auto fail = [this](const char * why) {
+        (void)munmap(const_cast<uint8_t *>(m_map), m_map_size);
+        throw Error(std::string("SnapshotMemoryReader: \"") + m_filename + "\" " + why);
+    };
+
+    Header header;
+    std::copy(m_map, m_map + sizeof(Header), reinterpret_cast<uint8_t *>(&header));
+    if (!std::equal(header.magic, header.magic + k_magic_size, k_magic)) {
+        fail("is not a snapshot file.");
+    }
+    if (header.version != k_version) {
+        fail("has an unsupported version.");
+    }
+    auto table_end = sizeof(Header) + sizeof(Segment)*std::size_t(header.segment_count);
+    if (table_end > m_map_size) {
+        fail("has a truncated segment table.");
+    }
+
+    m_regions.reserve(header.segment_count);
+    m_offsets.reserve(header.segment_count);
+    for (std::size_t i = 0; i != header.segment_count; ++i) {
+        Segment seg;
+        const auto * src = m_map + sizeof(Header) + sizeof(Segment)*i;
+        std::copy(src, src + sizeof(Segment), reinterpret_cast<uint8_t *>(&seg));
+        if (seg.file_offset > m_map_size || seg.length > m_map_size - seg.file_offset) {
+            fail("has a segment past the end of the file.");
+        }
+        if (!m_regions.empty() && m_regions.back().end() > seg.address) {
+            fail("has unsorted or overlapping segments.");
+        }
+        m_regions.push_back(MemoryRegion { Address(seg.address), std::size_t(seg.length) });
+        m_offsets.push_back(std::size_t(seg.file_offset));
+    }
+}
+
+SnapshotMemoryReader::~SnapshotMemoryReader()
+    { (void)munmap(const_cast<uint8_t *>(m_map), m_map_size); }
+
+void SnapshotMemoryReader::read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const
+{
+    const auto * src = view(addr, bytes_in_buf);
+    if (!src) {
+        throw Error("SnapshotMemoryReader::read: address range was not recorded in the snapshot.");
+    }
+    std::copy(src, src + bytes_in_buf, buf);
+}
+
+void SnapshotMemoryReader::describe_source(std::ostream & out) const {
+    out << "Snapshot file \"" << m_filename << "\".";
+}
+
+const uint8_t * SnapshotMemoryReader::view
+    (Address addr, std::size_t length) const noexcept
+{
+    auto idx = find_in_regions(m_regions, addr, length);
+    if (idx == k_no_region) return nullptr;
+    return m_map + m_offsets[idx] + (addr - m_regions[idx].address);
+}
+
+// ----------------------------------------------------------------------------
+
+/* static */ std::shared_ptr<const MemorySnapshot> MemorySnapshot::take
+    (const MemoryReader & source, MemoryRegionList regions)
+{
+    merge_regions(regions);
+    std::shared_ptr<MemorySnapshot> rv(new MemorySnapshot());
+    rv->retake(source, regions);
+    return rv;
+}
+
+/* static */ std::shared_ptr<const MemorySnapshot> MemorySnapshot::take
+    (const MemoryReader & source, MemoryRegionList & regions, SnapshotPool & pool)
+{
+    merge_regions(regions);
+    auto itr = std::find_if(pool.begin(), pool.end(),
+        [](const std::shared_ptr<MemorySnapshot> & snapshot)
+        // snapshots only leave the pool through what take returns, so once
+        // only the pool holds one, nobody can pick it up again
+        { return snapshot.use_count() == 1; });
+    if (itr == pool.end()) {
+        pool.push_back(std::shared_ptr<MemorySnapshot>(new MemorySnapshot()));
+        itr = pool.end() - 1;
+    } else {
+        // pairs with the release of the last reader's reference
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    (**itr).retake(source, regions);
+    return *itr;
+}
+
+/* private */ void MemorySnapshot::retake
+    (const MemoryReader & source, const MemoryRegionList & regions)
+{
+    m_regions.clear();
+    m_offsets.clear();
+    m_requests.clear();
+
+    std::size_t total = 0;
+    for (const auto & region : regions) total += region.length;
+    m_bytes.resize(total);
+
+    auto & requests = m_requests;
+    requests.reserve(regions.size());
+    auto * dest = m_bytes.data();
+    for (const auto & region : regions) {
+        requests.push_back(ReadRequest { region.address, dest, region.length });
+        dest += region.length;
+    }
+
+    // one pass for everything, then region by region only if that fails
+    bool all_good = source.try_read_batch(requests) == ReadStatus::ok;
+    m_regions.reserve(regions.size());
+    m_offsets.reserve(regions.size());
+    for (std::size_t i = 0; i != requests.size(); ++i) {
+        const auto & req = requests[i];
+        if (!all_good) {
+            auto status = source.try_read(req.address, req.destination, req.length);
+            if (status == ReadStatus::no_permission) {
+                throw PermissionError("MemorySnapshot::take: lost permission to "
+                                      "read the target's memory.");
+            } else if (status == ReadStatus::no_process) {
+                throw Error("MemorySnapshot::take: the target process is gone.");
+            } else if (status != ReadStatus::ok) {
+                continue;
+            }
+        }
+        m_regions.push_back(regions[i]);
+        m_offsets.push_back(std::size_t(req.destination - m_bytes.data()));
+    }
+}
+
+void MemorySnapshot::read(Address addr, uint8_t * buf, std::size_t bytes_in_buf) const {
+    const auto * src = view(addr, bytes_in_buf);
+    if (!src) {
+        throw Error("MemorySnapshot::read: address range was not taken in the snapshot.");
+    }
+    std::copy(src, src + bytes_in_buf, buf);
+}
+
+ReadStatus MemorySnapshot::try_read
+    (Address addr, uint8_t * buf, std::size_t bytes_in_buf) const noexcept
+{
+    const auto * src = view(addr, bytes_in_buf);
+    if (!src) return ReadStatus::bad_address;
+    std::copy(src, src + bytes_in_buf, buf);
+    return ReadStatus::ok;
+}
+
+void MemorySnapshot::describe_source(std::ostream & out) const {
+    out << "In memory snapshot of " << m_regions.size() << " regions.";
+}
+
+const uint8_t * MemorySnapshot::view(Address addr, std::size_t length) const noexcept {
+    auto idx = find_in_regions(m_regions, addr, length);
+    if (idx == k_no_region) return nullptr;
+    return m_bytes.data() + m_offsets[idx] + (addr - m_regions[idx].address);
+}
@@ -0,0 +1,160 @@
+/****************************************************************************
+
+    File: SnapshotMemoryReader.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "MemoryReader.hpp"
+
+/** Snapshot files hold copies of chosen regions of a target's memory, so that
+ *  the decode and render pipeline can be run without a live game.
+ *
+ *  Layout (all integers in the writing machine's byte order):
+ *  - header:  8 byte magic "APIRSNAP", u32 version, u32 segment count
+ *  - segment table: per segment u64 address, u64 length, u64 file offset
+ *    (sorted by address, non-overlapping)
+ *  - segment data
+ */
+namespace SnapshotFormat {
+
+constexpr const char     k_magic[] = "APIRSNAP";
+constexpr const int      k_magic_size = 8;
+constexpr const uint32_t k_version = 1;
+
+struct Header {
+    char     magic[k_magic_size];
+    uint32_t version;
+    uint32_t segment_count;
+};
+
+struct Segment {
+    uint64_t address;
+    uint64_t length;
+    uint64_t file_offset;
+};
+
+} // end of SnapshotFormat namespace
+
+/** Reads the given regions out of the source and writes them to a snapshot
+ *  file, overlapping regions are merged first.
+ *  @throws if any region cannot be read, or the file cannot be written
+ */
+void write_snapshot
+    (const std::string & filename, const MemoryReader & source, MemoryRegionList regions);
+
+/** Serves reads straight out of a memory mapped snapshot file. Reads that
+ *  fall outside of the recorded segments throw, as they would for a live
+ *  process.
+ */
+class SnapshotMemoryReader final : public MemoryReader {
+public:
+    explicit SnapshotMemoryReader(const std::string & filename);
+
+    SnapshotMemoryReader(const SnapshotMemoryReader &) = delete;
+    SnapshotMemoryReader & operator = (const SnapshotMemoryReader &) = delete;
+
+    ~SnapshotMemoryReader() override;
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return view(addr, length) != nullptr; }
+
+    void describe_source(std::ostream &) const override;
+
+    /** Zero copy access to the mapped file.
+     *  @returns pointer to the recorded bytes for [addr, addr + length) or
+     *           nullptr if no single segment covers it
+     */
+    const uint8_t * view(Address addr, std::size_t length) const noexcept;
+
+    const MemoryRegionList & regions() const noexcept { return m_regions; }
+
+private:
+    std::string m_filename;
+    const uint8_t * m_map = nullptr;
+    std::size_t m_map_size = 0;
+
+    // parallel arrays, regions for searching, offsets into the map
+    MemoryRegionList m_regions;
+    std::vector<std::size_t> m_offsets;
+};
+
+class MemorySnapshot;
+
+/** Snapshots kept for reuse, see MemorySnapshot::take. */
+using SnapshotPool = std::vector<std::shared_ptr<MemorySnapshot>>;
+
+/** A copy of chosen regions of a target's memory, held in memory and taken
+ *  in one batched pass, never changed once taken. Lets everything decoded
+ *  in a tick see the target as it was at a single moment, and costs no
+ *  syscalls to read from however many times. Reads outside of the taken
+ *  regions fail as bad addresses, as they would for a live process.
+ */
+class MemorySnapshot final : public MemoryReader {
+public:
+    /** Reads regions (merged first) out of source, regions which cannot be
+     *  read are left out.
+     *  @throws if the target is gone, or permission is lost
+     */
+    static std::shared_ptr<const MemorySnapshot> take
+        (const MemoryReader & source, MemoryRegionList regions);
+
+    /** As above, but into a snapshot from the pool which nobody else holds
+     *  anymore (or a new one added to it), keeping its buffers, so that once
+     *  warmed up taking a snapshot each tick allocates nothing.
+     *  @param regions merged in place
+     */
+    static std::shared_ptr<const MemorySnapshot> take
+        (const MemoryReader & source, MemoryRegionList & regions, SnapshotPool & pool);
+
+    void read(Address, uint8_t * buf, std::size_t bytes_in_buf) const override;
+
+    ReadStatus try_read(Address, uint8_t * buf, std::size_t bytes_in_buf) const noexcept override;
+
+    bool is_readable(Address addr, std::size_t length) const override
+        { return view(addr, length) != nullptr; }
+
+    void describe_source(std::ostream &) const override;
+
+    /** Zero copy access to the snapshot.
+     *  @returns pointer to the taken bytes for [addr, addr + length) or
+     *           nullptr if no single region covers it
+     */
+    const uint8_t * view(Address addr, std::size_t length) const noexcept;
+
+    /** @returns every region taken, sorted and non-overlapping */
+    const MemoryRegionList & regions() const noexcept { return m_regions; }
+
+    std::size_t size_in_bytes() const noexcept { return m_bytes.size(); }
+
+private:
+    MemorySnapshot() {}
+
+    /** Reads merged regions anew, replacing everything taken before. */
+    void retake(const MemoryReader & source, const MemoryRegionList & regions);
+
+    // parallel arrays, regions for searching, offsets into the bytes
+    MemoryRegionList m_regions;
+    std::vector<std::size_t> m_offsets;
+    std::vector<uint8_t> m_bytes;
+    // retake only, kept with the rest of the buffers
+    ReadRequestList m_requests;
+};
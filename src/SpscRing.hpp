@@ -0,0 +1,82 @@
+/****************************************************************************
+
+    File: SpscRing.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <utility>
+
+#include <cstddef>
+
+/** A lock-free, bounded, single producer single consumer queue.
+ *  Exactly one thread may push, and exactly one (other) thread may pop.
+ */
+template <typename T, std::size_t kt_capacity>
+class SpscRing {
+public:
+    static_assert(kt_capacity > 1 && (kt_capacity & (kt_capacity - 1)) == 0,
+                  "Capacity must be a power of two.");
+
+    /** Producer only.
+     *  @returns false (leaving obj alone) if the ring is full
+     */
+    bool try_push(T && obj) {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cached_tail == kt_capacity) {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cached_tail == kt_capacity) return false;
+        }
+        m_slots[head & k_mask] = std::move(obj);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer only.
+     *  @returns false if the ring is empty
+     */
+    bool try_pop(T & obj) {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cached_head) {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            if (tail == m_cached_head) return false;
+        }
+        obj = std::move(m_slots[tail & k_mask]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    static constexpr std::size_t capacity() noexcept { return kt_capacity; }
+
+private:
+    static constexpr const std::size_t k_mask = kt_capacity - 1;
+    // keeps producer and consumer from sharing cache lines
+    static constexpr const std::size_t k_cache_line = 64;
+
+    std::array<T, kt_capacity> m_slots;
+
+    alignas(k_cache_line) std::atomic<std::size_t> m_head { 0 };
+    std::size_t m_cached_tail = 0; // producer's
+
+    alignas(k_cache_line) std::atomic<std::size_t> m_tail { 0 };
+    std::size_t m_cached_head = 0; // consumer's
+};
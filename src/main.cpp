@@ -22,11 +22,11 @@
 #include <thread>
 #include <chrono>
 
-#include <cassert>
-
 #include <ncurses.h>
 
 #include "NCursesGrid.hpp"
+#include "Benchmarks.hpp"
+#include "ReadProfile.hpp"
 
 #include "pso/ProcessWatcher.hpp"
 
@@ -44,6 +44,10 @@ void do_render   (AppStatePtr, NCursesGrid &);
 } // end of <anonymous> namespace
 
 int main() {
+    if (run_requested_benchmark()) {
+        dump_read_profile();
+        return 0;
+    }
     // run tests before even starting
     NCursesGrid ncgrid;
     AppStateMap statemap;
@@ -73,6 +77,7 @@ int main() {
             }
             do_render(state_ptr, ncgrid);
         } catch (QuitAppException &) {
+            dump_read_profile();
             return 0;
         }
     }
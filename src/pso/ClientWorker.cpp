@@ -0,0 +1,274 @@
+/****************************************************************************
+
+    File: ClientWorker.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "ClientWorker.hpp"
+#include "Item.hpp"
+
+#include "../AllocationCount.hpp"
+#include "../CachingMemoryReader.hpp"
+#include "../CaptureFile.hpp"
+#include "../ReadProfile.hpp"
+#include "../SnapshotMemoryReader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+std::mutex s_totals_mutex;
+RefreshStats s_totals;
+
+/** @returns a list from the pool only it holds, or a new one added to it */
+std::shared_ptr<PublishedItems> reusable_published(std::vector<std::shared_ptr<PublishedItems>> &);
+
+} // end of <anonymous> namespace
+
+RefreshStats & RefreshStats::operator += (const RefreshStats & rhs) noexcept {
+    refreshes            += rhs.refreshes;
+    allocations          += rhs.allocations;
+    allocating_refreshes += rhs.allocating_refreshes;
+    return *this;
+}
+
+ClientWorker::ClientWorker
+    (std::shared_ptr<const MemoryReader> source, std::string label,
+     std::shared_ptr<CaptureWriter> capture, int pid_):
+    m_source(std::move(source)),
+    m_label(std::move(label)),
+    m_capture(std::move(capture)),
+    m_pid(pid_)
+{
+    if (!m_source) {
+        throw std::invalid_argument("ClientWorker::ClientWorker: source must be set.");
+    }
+    m_reader = std::make_shared<CachingMemoryReader>(m_source);
+    for (const auto * kind : { &ItemListKind::inventory(), &ItemListKind::floor(),
+                               &ItemListKind::bank() })
+    { m_trackers.emplace_back(*kind); }
+    m_latest.resize(m_trackers.size());
+    m_pools .resize(m_trackers.size());
+}
+
+ClientWorker::~ClientWorker() {
+    if (!m_thread.joinable()) return;
+    {
+    std::unique_lock<std::mutex> lock(m_stop_mutex);
+    m_stopping = true;
+    }
+    m_stop_signal.notify_all();
+    m_thread.join();
+}
+
+void ClientWorker::start(double rate_hz) {
+    if (m_thread.joinable()) return;
+    if (!(rate_hz > 0.)) {
+        throw std::invalid_argument("ClientWorker::start: rate must be a "
+                                    "positive number.");
+    }
+    m_thread = std::thread([this, rate_hz]() { run(rate_hz); });
+}
+
+void ClientWorker::step(double et) {
+    if (m_status != k_running) return;
+    try {
+        // the whole refresh is counted, from the first read to publishing
+        auto allocations = thread_allocation_count();
+        static ReadSite s_site("tick snapshot");
+        ReadSiteScope scope(s_site);
+        // everything read from here on out (until the next step) is fresh
+        m_reader->invalidate();
+        m_regions.clear();
+        collect_item_regions(*m_reader, m_globals, m_regions);
+        auto snapshot = MemorySnapshot::take(*m_reader, m_regions, m_snapshots);
+
+        m_globals.update(*snapshot);
+        for (std::size_t i = 0; i != m_trackers.size(); ++i) {
+            if (!m_trackers[i].update(*snapshot, m_globals, et)) continue;
+            auto published = publish(m_trackers[i], m_pools[i]);
+            std::unique_lock<std::mutex> lock(m_latest_mutex);
+            m_latest[i].swap(published);
+        }
+        RefreshStats stats;
+        stats.refreshes            = 1;
+        stats.allocations          = thread_allocation_count() - allocations;
+        stats.allocating_refreshes = stats.allocations ? 1 : 0;
+        {
+        std::unique_lock<std::mutex> lock(s_totals_mutex);
+        s_totals += stats;
+        }
+        if (m_capture) m_capture->add_frame(*snapshot, snapshot->regions());
+
+        std::unique_lock<std::mutex> lock(m_latest_mutex);
+        m_snapshot = std::move(snapshot);
+    } catch (PermissionError &) {
+        m_status = k_lost_permission;
+        throw;
+    } catch (...) {
+        m_status = k_failed;
+        throw;
+    }
+}
+
+std::shared_ptr<const PublishedItems> ClientWorker::latest(const ItemListKind & kind) const {
+    std::unique_lock<std::mutex> lock(m_latest_mutex);
+    for (const auto & published : m_latest) {
+        if (published && published->kind == &kind) return published;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const MemorySnapshot> ClientWorker::latest_snapshot() const {
+    std::unique_lock<std::mutex> lock(m_latest_mutex);
+    return m_snapshot;
+}
+
+/* static */ RefreshStats ClientWorker::total_refresh_stats() {
+    std::unique_lock<std::mutex> lock(s_totals_mutex);
+    return s_totals;
+}
+
+/* static */ void ClientWorker::reset_total_refresh_stats() {
+    std::unique_lock<std::mutex> lock(s_totals_mutex);
+    s_totals = RefreshStats();
+}
+
+/* private */ void ClientWorker::run(double rate_hz) {
+    using namespace std::chrono;
+    using Clock = steady_clock;
+    const auto period = duration_cast<Clock::duration>(duration<double>(1. / rate_hz));
+    auto last = Clock::now();
+    auto next = last;
+    std::unique_lock<std::mutex> lock(m_stop_mutex);
+    while (!m_stopping) {
+        lock.unlock();
+        auto now = Clock::now();
+        try {
+            step(duration<double>(now - last).count());
+        } catch (...) {
+            // status says why, the UI drops the client
+            return;
+        }
+        last = now;
+        lock.lock();
+        // fell behind? don't try to catch up
+        next = std::max(next + period, Clock::now());
+        m_stop_signal.wait_until(lock, next, [this]() { return m_stopping; });
+    }
+}
+
+/* static */ std::shared_ptr<const PublishedItems>
+    ClientWorker::publish(const ItemTracker & tracker, PublishedPool & pool)
+{
+    auto published = reusable_published(pool);
+    published->kind       = &tracker.kind();
+    published->addresses  = tracker.addresses();
+    published->item_count = int(tracker.items().size());
+
+    // the old strings go first, they're in the arena
+    auto & strings = published->item_strings;
+    strings.clear();
+    published->arena.reset();
+    // each item was formatted once by the tracker, when it last changed
+    for (const auto * item : tracker.items()) {
+        strings.emplace_back(item->line.data(), item->line.size(), &published->arena);
+    }
+    return published;
+}
+
+// ----------------------------------------------------------------------------
+
+void ClientSet::add(std::shared_ptr<ClientWorker> client) {
+    if (!client) {
+        throw std::invalid_argument("ClientSet::add: client must be set.");
+    }
+    m_clients.emplace_back(std::move(client));
+}
+
+bool ClientSet::contains(int pid) const noexcept {
+    return std::any_of(m_clients.begin(), m_clients.end(),
+        [pid](const std::shared_ptr<ClientWorker> & client)
+        { return client->pid() == pid; });
+}
+
+bool ClientSet::has_live_clients() const noexcept {
+    return std::any_of(m_clients.begin(), m_clients.end(),
+        [](const std::shared_ptr<ClientWorker> & client)
+        { return client->pid() != k_no_pid; });
+}
+
+ClientWorker & ClientSet::selected() const {
+    if (m_clients.empty()) {
+        throw std::out_of_range("ClientSet::selected: there are no clients.");
+    }
+    return *m_clients[m_selected];
+}
+
+void ClientSet::select(std::size_t index) noexcept {
+    if (index < m_clients.size()) m_selected = index;
+}
+
+void ClientSet::select_next(int step) noexcept {
+    if (m_clients.empty()) return;
+    auto count = int(m_clients.size());
+    m_selected = std::size_t((((int(m_selected) + step) % count) + count) % count);
+}
+
+bool ClientSet::remove_stopped(bool & lost_permission) {
+    const auto * selected = m_clients.empty() ? nullptr : m_clients[m_selected].get();
+    // status is read once per client, a worker may stop at any moment
+    auto new_end = std::remove_if(m_clients.begin(), m_clients.end(),
+        [&lost_permission](const std::shared_ptr<ClientWorker> & client)
+    {
+        auto status = client->status();
+        if (status == ClientWorker::k_lost_permission) lost_permission = true;
+        return status != ClientWorker::k_running;
+    });
+    if (new_end == m_clients.end()) return false;
+    m_clients.erase(new_end, m_clients.end());
+
+    // keep the same client selected if it's still around
+    auto itr = std::find_if(m_clients.begin(), m_clients.end(),
+        [selected](const std::shared_ptr<ClientWorker> & client)
+        { return client.get() == selected; });
+    m_selected = itr == m_clients.end() ? 0 : std::size_t(itr - m_clients.begin());
+    return true;
+}
+
+namespace {
+
+std::shared_ptr<PublishedItems> reusable_published
+    (std::vector<std::shared_ptr<PublishedItems>> & pool)
+{
+    for (const auto & published : pool) {
+        // lists only leave the pool through the worker's latest, so once
+        // only the pool holds one, nobody can pick it up again
+        if (published.use_count() != 1) continue;
+        // pairs with the release of the last reader's reference
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return published;
+    }
+    pool.push_back(std::make_shared<PublishedItems>());
+    return pool.back();
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,215 @@
+/****************************************************************************
+
+    File: ClientWorker.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "ItemTracker.hpp"
+
+#include "../RefreshArena.hpp"
+#include "../SnapshotMemoryReader.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class CachingMemoryReader;
+class CaptureWriter;
+
+/** An item list as a worker decoded and formatted it. Never changed once
+ *  published, so the UI may hold onto it for as long as it likes. Once the
+ *  UI lets go, the worker refills it (and its arena) with a later list.
+ */
+struct PublishedItems {
+    const ItemListKind * kind = nullptr;
+    // holds the strings, reset each time the list is refilled
+    RefreshArena arena;
+    // one per line, in the items' color markup
+    std::vector<std::pmr::string> item_strings;
+    // of the listed items, in display order
+    AddressList addresses;
+    int item_count = 0;
+};
+
+/** Heap allocations made by refreshes, from taking the snapshot to
+ *  publishing the formatted lists (writing a capture, if one was asked for,
+ *  is left out), which once warmed up should be none at all. Only counted
+ *  in builds with MACRO_COUNT_ALLOCATIONS.
+ */
+struct RefreshStats {
+    std::size_t refreshes   = 0;
+    std::size_t allocations = 0;
+    // refreshes which made any allocation
+    std::size_t allocating_refreshes = 0;
+
+    RefreshStats & operator += (const RefreshStats &) noexcept;
+};
+
+/** Reads one client (game process) with its own caches, and keeps every
+ *  list of items (inventory, floor and bank) decoded and formatted.
+ *
+ *  Each step takes one snapshot of every region any list needs, in one
+ *  batched pass, and all lists are decoded from it. So every list always
+ *  reflects the same moment, and switching between views costs nothing.
+ *
+ *  Once started, steps run on the worker's own thread, and the UI only
+ *  picks up whatever was published last. Workers never started are stepped
+ *  by their owner (as offline readers and benchmarks do).
+ */
+class ClientWorker {
+public:
+    enum Status { k_running, k_lost_permission, k_failed };
+
+    static constexpr const double k_default_rate = 25.;
+
+    /** @param pid of the process source reads, if it reads a live one */
+    ClientWorker(std::shared_ptr<const MemoryReader> source, std::string label,
+                 std::shared_ptr<CaptureWriter> capture = nullptr,
+                 int pid = k_no_pid);
+
+    ClientWorker(const ClientWorker &) = delete;
+    ClientWorker & operator = (const ClientWorker &) = delete;
+
+    ~ClientWorker();
+
+    /** Starts updating on the worker's own thread, does nothing if already
+     *  started.
+     */
+    void start(double rate_hz = k_default_rate);
+
+    bool is_started() const noexcept { return m_thread.joinable(); }
+
+    /** Takes a snapshot, updates every list from it, and publishes those
+     *  which changed. Not to be called once started.
+     *  @throws as the item readers do, the worker stops for good on any throw
+     */
+    void step(double elapsed_time);
+
+    /** @returns the last published list of the kind, nullptr if there is
+     *           none yet
+     */
+    std::shared_ptr<const PublishedItems> latest(const ItemListKind &) const;
+
+    /** @returns the snapshot the last step decoded from, nullptr if there
+     *           is none yet
+     */
+    std::shared_ptr<const MemorySnapshot> latest_snapshot() const;
+
+    Status status() const noexcept { return m_status.load(); }
+
+    const std::string & label() const noexcept { return m_label; }
+
+    /** @returns k_no_pid if the source is not a live process */
+    int pid() const noexcept { return m_pid; }
+
+    /** @returns the uncached reader, which is safe to use from any thread */
+    const std::shared_ptr<const MemoryReader> & source() const noexcept
+        { return m_source; }
+
+    /** @returns stats accumulated over every step of every worker (in any
+     *           thread) since the last reset
+     */
+    static RefreshStats total_refresh_stats();
+
+    static void reset_total_refresh_stats();
+
+private:
+    // every list published for a tracker, the UI may still hold some
+    using PublishedPool = std::vector<std::shared_ptr<PublishedItems>>;
+
+    void run(double rate_hz);
+
+    /** @returns a formatted copy of the tracker's items, in a list from the
+     *           pool which nobody else holds anymore (if there is one)
+     */
+    static std::shared_ptr<const PublishedItems>
+        publish(const ItemTracker &, PublishedPool &);
+
+    std::shared_ptr<const MemoryReader> m_source;
+    std::string m_label;
+    std::shared_ptr<CaptureWriter> m_capture;
+    int m_pid;
+
+    std::atomic<Status> m_status { k_running };
+
+    // one published list per tracker, in the same order
+    mutable std::mutex m_latest_mutex;
+    std::vector<std::shared_ptr<const PublishedItems>> m_latest;
+    std::shared_ptr<const MemorySnapshot> m_snapshot;
+
+    // worker only: pages are shared by every read in a step
+    std::shared_ptr<CachingMemoryReader> m_reader;
+    ItemGlobals m_globals;
+    // worker only: kept between steps, so refreshes reuse their storage
+    MemoryRegionList m_regions;
+    SnapshotPool m_snapshots;
+    std::vector<ItemTracker> m_trackers;
+    // one per tracker, in the same order
+    std::vector<PublishedPool> m_pools;
+
+    std::mutex m_stop_mutex;
+    std::condition_variable m_stop_signal;
+    bool m_stopping = false;
+    std::thread m_thread;
+};
+
+/** Every client the item views can switch between, and which one of them is
+ *  shown. Handed along from view to view.
+ */
+class ClientSet {
+public:
+    void add(std::shared_ptr<ClientWorker>);
+
+    bool empty() const noexcept { return m_clients.empty(); }
+
+    std::size_t size() const noexcept { return m_clients.size(); }
+
+    /** @returns true if any client reads the process with the given pid */
+    bool contains(int pid) const noexcept;
+
+    /** @returns true if any client reads a live process (rather than a
+     *           snapshot, a replay or a capture)
+     */
+    bool has_live_clients() const noexcept;
+
+    /** @throws std::out_of_range if there are no clients */
+    ClientWorker & selected() const;
+
+    std::size_t selected_index() const noexcept { return m_selected; }
+
+    /** Does nothing if index is out of range. */
+    void select(std::size_t index) noexcept;
+
+    /** Selects a client step places away, wrapping around either end. */
+    void select_next(int step) noexcept;
+
+    /** Removes every client whose worker stopped.
+     *  @param lost_permission set if any of them stopped for lack of ptrace
+     *                         permission (left alone otherwise)
+     *  @returns true if any were removed
+     */
+    bool remove_stopped(bool & lost_permission);
+
+private:
+    std::vector<std::shared_ptr<ClientWorker>> m_clients;
+    std::size_t m_selected = 0;
+};
@@ -22,7 +22,6 @@
 #include "Item.hpp"
 #include "ItemDb.hpp"
 #include "../AppStateDefs.hpp"
-#include "../MemoryReader.hpp"
 
 #include <numeric>
 #include <iostream>
@@ -41,7 +40,7 @@ using EsRankName = EsWeapon::NameArray;
 
 WeaponSpecial to_weapon_special(uint8_t);
 
-EsRankName parse_esrank_name(Address addr, const MemoryReader &);
+EsRankName parse_esrank_name(const RecordBytes &, FieldLayout);
 
 } // end of <anonymous> namespace
 
@@ -79,22 +78,20 @@ char interpret_special(WeaponSpecial spec) {
 
 // ----------------------------------------------------------------------------
 
-void WeaponBase::load_from_(Address addr, const MemoryReader & memory) {
-    static constexpr const int k_special = 0x1F6;
-    static constexpr const int k_grind   = 0x1F5;
-    load_grind_and_special(addr + k_grind, addr + k_special, memory);
+void WeaponBase::load_from_(const RecordBytes & record) {
+    using namespace InventoryLayout;
+    load_grind_and_special(record, k_weapon_grind, k_weapon_special);
 }
 
-void WeaponBase::load_from_bank_(Address addr, const MemoryReader & memory) {
-    static constexpr const int k_special = 0x4;
-    static constexpr const int k_grind   = 0x3;
-    load_grind_and_special(addr + k_grind, addr + k_special, memory);
+void WeaponBase::load_from_bank_(const RecordBytes & record) {
+    using namespace BankLayout;
+    load_grind_and_special(record, k_weapon_grind, k_weapon_special);
 }
 
 /* private */ void WeaponBase::load_grind_and_special
-    (Address grindaddr, Address specaddr, const MemoryReader & memory)
+    (const RecordBytes & record, FieldLayout grindfield, FieldLayout specfield)
 {
-    uint8_t wraptekspec_datum = memory.read_u8(specaddr);
+    auto wraptekspec_datum = record.get<uint8_t>(specfield);
     special = to_weapon_special(wraptekspec_datum % 64);
     if (wraptekspec_datum > 0xBF) {
         wrapped = true ;
@@ -105,7 +102,7 @@ void WeaponBase::load_from_bank_(Address addr, const MemoryReader & memory) {
         wrapped = true;
     }
 
-    grind = memory.read_u8(grindaddr);
+    grind = record.get<uint8_t>(grindfield);
 }
 
 // ----------------------------------------------------------------------------
@@ -131,10 +128,10 @@ void DefenseItem::print_def_stats(std::ostream & out) const {
 }
 
 void DefenseItem::load_def_stats
-    (Address evp_addr, Address dfp_addr, const MemoryReader & memory)
+    (const RecordBytes & record, FieldLayout evpfield, FieldLayout dfpfield)
 {
-    dfp = memory.read_u8(evp_addr);
-    evp = memory.read_u8(dfp_addr);
+    dfp = record.get<uint8_t>(evpfield);
+    evp = record.get<uint8_t>(dfpfield);
     mins_maxes = &get_defense_item_info(fullcode);
 }
 
@@ -146,13 +143,14 @@ void Tool::print_to(std::ostream & out) const {
         out << " x" << quantity;
 }
 
-void Tool::load_from_(Address addr, const MemoryReader & memory) {
-    auto count = memory.read_u32(addr + k_count_offset);
-    quantity = count ^ (addr + k_count_offset);
+void Tool::load_from_(const RecordBytes & record) {
+    using InventoryLayout::k_tool_count;
+    auto count = record.get<uint32_t>(k_tool_count);
+    quantity = count ^ (record.address() + k_tool_count.offset);
 }
 
-void Tool::load_from_bank_(Address addr, const MemoryReader & memory) {
-    quantity = memory.read_u8(addr + 20);
+void Tool::load_from_bank_(const RecordBytes & record) {
+    quantity = record.get<uint8_t>(BankLayout::k_tool_count);
 }
 
 // ----------------------------------------------------------------------------
@@ -166,19 +164,22 @@ void Tech::print_to(std::ostream & out) const {
     out << "]";
 }
 
-void Tech::load_from_(Address addr, const MemoryReader & memory) {
-    static constexpr const int k_tech_type_offset = 0x108;
-    load_level_and_type(memory, addr + k_item_code_offset, addr + k_tech_type_offset);
+void Tech::load_from_(const RecordBytes & record) {
+    using namespace InventoryLayout;
+    load_level_and_type(record, k_fullcode, k_tech_type);
 }
 
-void Tech::load_from_bank_(Address addr, const MemoryReader & memory)
-    { load_level_and_type(memory, addr, addr + 4); }
+void Tech::load_from_bank_(const RecordBytes & record)
+{
+    using namespace BankLayout;
+    load_level_and_type(record, k_fullcode, k_tech_type);
+}
 
 void Tech::load_level_and_type
-    (const MemoryReader & memory, Address leveladdr, Address typeaddr)
+    (const RecordBytes & record, FieldLayout levelfield, FieldLayout typefield)
 {
-    level = ((memory.read_u32(leveladdr) >> 16) & 0xFF) + 1;
-    type  = get_tech_type(memory.read_u8(typeaddr));
+    level = ((record.get<uint32_t>(levelfield) >> 16) & 0xFF) + 1;
+    type  = get_tech_type(record.get<uint8_t>(typefield));
     set_name(to_string(type));
 }
 
@@ -192,14 +193,13 @@ void Meseta::set_quantity(int i) {
     out << "[" << TextPalette::k_gold << ":" << quantity << " Meseta]";
 }
 
-/* private */ void Meseta::load_from_(Address addr, const MemoryReader & memory) {
-    static constexpr const int k_meseta_offset = 0x100;
-    quantity = memory.read_u32(addr + k_meseta_offset);
+/* private */ void Meseta::load_from_(const RecordBytes & record) {
+    quantity = record.get<uint32_t>(InventoryLayout::k_meseta);
 }
 
-/* private */ void Meseta::load_from_bank_(Address addr, const MemoryReader & memory) {
+/* private */ void Meseta::load_from_bank_(const RecordBytes & record) {
     // sorry... what?
-    quantity = memory.read_u32(addr + 12);
+    quantity = record.get<uint32_t>(BankLayout::k_meseta);
 }
 
 // ----------------------------------------------------------------------------
@@ -231,22 +231,24 @@ void Weapon::print_to(std::ostream & out) const {
     }
 }
 
-void Weapon::load_from_(Address addr, const MemoryReader & memory) {
-    WeaponBase::load_from_(addr, memory);
-    load_attributes(addr + WeaponBase::k_stats_offset, memory);
+void Weapon::load_from_(const RecordBytes & record) {
+    WeaponBase::load_from_(record);
+    load_attributes(record, InventoryLayout::k_weapon_attributes);
 }
 
-void Weapon::load_from_bank_(Address addr, const MemoryReader & memory) {
-    WeaponBase::load_from_bank_(addr, memory);
-    load_attributes(addr + 6, memory);
+void Weapon::load_from_bank_(const RecordBytes & record) {
+    WeaponBase::load_from_bank_(record);
+    load_attributes(record, BankLayout::k_weapon_attributes);
 }
 
-void Weapon::load_attributes(Address attraddr, const MemoryReader & memory) {
+void Weapon::load_attributes(const RecordBytes & record, FieldLayout attrfield) {
     m_attr_count = 0;
     // on Solybum's [7 12]
     using AttrData = std::array<uint8_t, 3/* attributes */*2/* id + %s */>;
+    static_assert(sizeof(AttrData) == InventoryLayout::k_weapon_attributes.width &&
+                  sizeof(AttrData) == BankLayout::k_weapon_attributes.width, "");
     AttrData attributes;
-    memory.read(attraddr, attributes.data(), attributes.size());
+    record.copy(attrfield, attributes.data());
     for (auto idx : { 0, 2, 4 }) {
         if (attributes[idx] >= 6) continue;
         // I'll need to test negative percentages too
@@ -307,14 +309,14 @@ void EsWeapon::print_to(std::ostream & out) const {
     if (grind != 0) { out << " +" << grind; }
 }
 
-void EsWeapon::load_from_(Address addr, const MemoryReader & memory) {
-    WeaponBase::load_from_(addr, memory);
-    custom_name = parse_esrank_name(addr + k_name_offset, memory);
+void EsWeapon::load_from_(const RecordBytes & record) {
+    WeaponBase::load_from_(record);
+    custom_name = parse_esrank_name(record, InventoryLayout::k_esrank_name);
 }
 
-void EsWeapon::load_from_bank_(Address addr, const MemoryReader & memory) {
-    WeaponBase::load_from_bank_(addr, memory);
-    custom_name = parse_esrank_name(addr + 6, memory);
+void EsWeapon::load_from_bank_(const RecordBytes & record) {
+    WeaponBase::load_from_bank_(record);
+    custom_name = parse_esrank_name(record, BankLayout::k_esrank_name);
 }
 
 // ----------------------------------------------------------------------------
@@ -330,16 +332,16 @@ void Frame::print_to(std::ostream & out) const {
     print_def_stats(out);
 }
 
-void Frame::load_from_(Address addr, const MemoryReader & memory) {
-    slot_count = memory.read_u8(addr + k_slots_offset);
-    static constexpr const int k_dfp_offset = 0x1B9;
-    static constexpr const int k_evp_offset = 0x1BA;
-    load_def_stats(addr + k_evp_offset, addr + k_dfp_offset, memory);
+void Frame::load_from_(const RecordBytes & record) {
+    using namespace InventoryLayout;
+    slot_count = record.get<uint8_t>(k_frame_slots);
+    load_def_stats(record, k_frame_evp, k_frame_dfp);
 }
 
-void Frame::load_from_bank_(Address addr, const MemoryReader & memory) {
-    slot_count = memory.read_u8(addr + 5);
-    load_def_stats(addr + 8, addr + 6, memory);
+void Frame::load_from_bank_(const RecordBytes & record) {
+    using namespace BankLayout;
+    slot_count = record.get<uint8_t>(k_frame_slots);
+    load_def_stats(record, k_evp, k_dfp);
 }
 
 // ----------------------------------------------------------------------------
@@ -351,9 +353,9 @@ void Unit::print_to(std::ostream & out) const {
     }
 }
 
-void Unit::load_from_(Address, const MemoryReader &) {}
+void Unit::load_from_(const RecordBytes &) {}
 
-void Unit::load_from_bank_(Address, const MemoryReader &) {}
+void Unit::load_from_bank_(const RecordBytes &) {}
 
 // ----------------------------------------------------------------------------
 
@@ -362,14 +364,14 @@ void Barrier::print_to(std::ostream & out) const {
     print_def_stats(out);
 }
 
-void Barrier::load_from_(Address addr, const MemoryReader & memory) {
-    static constexpr const int k_dfp_offset = 0x1E4;
-    static constexpr const int k_evp_offset = 0x1E5;
-    load_def_stats(addr + k_evp_offset, addr + k_dfp_offset, memory);
+void Barrier::load_from_(const RecordBytes & record) {
+    using namespace InventoryLayout;
+    load_def_stats(record, k_barrier_evp, k_barrier_dfp);
 }
 
-void Barrier::load_from_bank_(Address addr, const MemoryReader & memory) {
-    load_def_stats(addr + 8, addr + 6, memory);
+void Barrier::load_from_bank_(const RecordBytes & record) {
+    using namespace BankLayout;
+    load_def_stats(record, k_evp, k_dfp);
 }
 
 // ----------------------------------------------------------------------------
@@ -404,22 +406,22 @@ void Mag::print_to(std::ostream & out) const {
     out << "\\]";
 }
 
-void Mag::load_from_(Address addr, const MemoryReader & memory) {
-    static constexpr const int k_stat_offset  = 0x1C0;
-    static constexpr const int k_timer_offset = 0x1B4;
-    load_stats(addr + k_stat_offset, memory);
-    seconds_until_feeding = int(std::round(memory.read_f32(addr + k_timer_offset) / 30.f));
+void Mag::load_from_(const RecordBytes & record) {
+    using namespace InventoryLayout;
+    load_stats(record, k_mag_stats);
+    seconds_until_feeding = int(std::round(record.get<float>(k_mag_timer) / 30.f));
 }
 
-void Mag::load_from_bank_(Address addr, const MemoryReader & memory) {
-    load_stats(addr + 4, memory);
+void Mag::load_from_bank_(const RecordBytes & record) {
+    load_stats(record, BankLayout::k_mag_stats);
     in_bank = true;
 }
 
-void Mag::load_stats(Address addr, const MemoryReader & memory) {
+void Mag::load_stats(const RecordBytes & record, FieldLayout statfield) {
     std::array<uint16_t, k_stat_count> rawstats;
-    memory.read(addr, reinterpret_cast<uint8_t *>(rawstats.data()),
-                rawstats.size()*sizeof(uint16_t));
+    static_assert(sizeof(rawstats) == InventoryLayout::k_mag_stats.width &&
+                  sizeof(rawstats) == BankLayout::k_mag_stats.width, "");
+    record.copy(statfield, rawstats.data());
 
     levels[k_def ] = rawstats[k_def ] / 100;
     levels[k_pow ] = rawstats[k_pow ] / 100;
@@ -450,13 +452,13 @@ WeaponSpecial to_weapon_special(uint8_t code) {
 }
 
 
-EsRankName parse_esrank_name(Address addr, const MemoryReader & memory) {
+EsRankName parse_esrank_name(const RecordBytes & record, FieldLayout namefield) {
     using NameData = std::array<uint16_t, 6 / sizeof(uint16_t)>;
+    static_assert(sizeof(NameData) == InventoryLayout::k_esrank_name.width &&
+                  sizeof(NameData) == BankLayout::k_esrank_name.width, "");
 
     NameData namedata = zero_initialized<NameData>();
-    memory.read(addr,
-                reinterpret_cast<uint8_t *>(namedata.data()),
-                namedata.size()*sizeof(uint16_t));
+    record.copy(namefield, namedata.data());
 
     EsRankName rv = zero_initialized<EsRankName>();
     auto itr = rv.begin();
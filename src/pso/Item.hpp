@@ -28,8 +28,6 @@
 #include <memory>
 #include <array>
 
-class MemoryReader;
-
 template <typename ArrayType>
 ArrayType zero_initialized() {
     using Element = typename ArrayType::value_type;
@@ -38,14 +36,10 @@ ArrayType zero_initialized() {
     return arr;
 }
 
-static constexpr const Address k_item_code_offset = 0xF2;
-
 class WeaponBase : public Item {
 protected:
-    static constexpr const int k_stats_offset = 0x1C8;
-
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
 
     int           grind   = 0;
     WeaponSpecial special = WeaponSpecial::none;
@@ -53,13 +47,13 @@ protected:
     bool          wrapped = false;
 
 private:
-    void load_grind_and_special(Address grindaddr, Address specaddr, const MemoryReader &);
+    void load_grind_and_special(const RecordBytes &, FieldLayout grind, FieldLayout special);
 };
 
 class DefenseItem : public Item {
 protected:
     void print_def_stats(std::ostream &) const;
-    void load_def_stats(Address evp_addr, Address dfp_addr, const MemoryReader &);
+    void load_def_stats(const RecordBytes &, FieldLayout evp, FieldLayout dfp);
 
 private:
     int evp = 0, dfp = 0;
@@ -68,45 +62,68 @@ private:
 
 // ----------------------------------------------------------------------------
 
+// print_to is public on every kind, so that an ItemValue (ItemValue.hpp)
+// prints with a direct call rather than through the vtable
+
 class Meseta final : public Item {
 public:
+    void print_to(std::ostream &) const override;
     void set_quantity(int);
 private:
-    void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_meseta_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_meseta_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
 
     int quantity = 0;
 };
 
 class Tool final : public Item {
-    static constexpr const int k_count_offset = 0x104;
+public:
     void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+
+private:
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_tool_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_tool_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
     int quantity = 0;
 };
 
 class Tech final : public Item {
+public:
     void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
 
-    void load_level_and_type(const MemoryReader &, Address leveladdr, Address typeaddr);
+private:
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_tech_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_tech_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
+
+    void load_level_and_type(const RecordBytes &, FieldLayout level, FieldLayout type);
 
     TechType type  = TechType::resta; // objectively the best tech
     int      level = 0;
 };
 
 class Weapon final : public WeaponBase {
+public:
+    void print_to(std::ostream &) const override;
+
+private:
     static constexpr const int k_num_attrs = 5;
     using AttrArray = std::array<int8_t, k_num_attrs>;
 
-    void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_weapon_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_weapon_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
 
-    void load_attributes(Address attraddr, const MemoryReader & memory);
+    void load_attributes(const RecordBytes &, FieldLayout);
     void print_single_attribute(std::ostream &) const;
     void print_multiple_attributes(std::ostream &) const;
     static char get_attribute_color(int8_t, bool hit);
@@ -117,23 +134,31 @@ class Weapon final : public WeaponBase {
 
 class EsWeapon final : public WeaponBase {
     static constexpr const int k_max_name = 8 + 1; // null terminated
-    static constexpr const int k_name_offset = WeaponBase::k_stats_offset;
 public:
     using NameArray = std::array<char, k_max_name>;
-private:
+
     void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+
+private:
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_esrank_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_esrank_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
 
     NameArray custom_name = zero_initialized<NameArray>();
 };
 
 class Frame final : public DefenseItem {
-    static constexpr const int k_slots_offset = 0x1B8;
-
+public:
     void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+
+private:
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_frame_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_frame_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
 
     int slot_count = 0;
 };
@@ -141,18 +166,34 @@ class Frame final : public DefenseItem {
 // barriers and units may have other stat boosts
 
 class Barrier final : public DefenseItem {
+public:
     void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+
+private:
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_barrier_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_barrier_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
 };
 
 class Unit final : public Item {
+public:
     void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+
+private:
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_plain_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_plain_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
 };
 
 class Mag final : public Item {
+public:
+    void print_to(std::ostream &) const override;
+
+private:
     // need to double check!
     static constexpr const int k_def  = 0;
     static constexpr const int k_pow  = 1;
@@ -162,11 +203,13 @@ class Mag final : public Item {
 
     using StatArray = std::array<uint8_t, k_stat_count>;
 
-    void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override;
-    void load_from_bank_(Address, const MemoryReader &) override;
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_mag_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_mag_span; }
+
+    void load_from_(const RecordBytes &) override;
+    void load_from_bank_(const RecordBytes &) override;
 
-    void load_stats(Address, const MemoryReader &);
+    void load_stats(const RecordBytes &, FieldLayout);
 
     StatArray levels = zero_initialized<StatArray>();
     StatArray percentages = zero_initialized<StatArray>();
@@ -175,7 +218,13 @@ class Mag final : public Item {
 };
 
 class TotallyUnknownItem final : public Item {
+public:
     void print_to(std::ostream &) const override;
-    void load_from_(Address, const MemoryReader &) override {}
-    void load_from_bank_(Address, const MemoryReader &) override {}
+
+private:
+    RecordSpan inventory_span() const noexcept override { return InventoryLayout::k_plain_span; }
+    RecordSpan bank_span     () const noexcept override { return BankLayout     ::k_plain_span; }
+
+    void load_from_(const RecordBytes &) override {}
+    void load_from_bank_(const RecordBytes &) override {}
 };
@@ -121,7 +121,7 @@ private:
     case 0x0E: return Tt::ryuker ;
     case 0x11: return Tt::reverser;
     default:
-        throw std::runtime_error("get_tech_type: no tech associated with this code.");
+        throw std::invalid_argument("get_tech_type: no tech associated with this code.");
     }
 }
 
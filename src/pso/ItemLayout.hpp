@@ -0,0 +1,205 @@
+/****************************************************************************
+
+    File: ItemLayout.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "../Defs.hpp"
+
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+
+#include <cstring>
+
+/** Where a single field lives, relative to the start of an item's record. */
+struct FieldLayout {
+    Address     offset;
+    std::size_t width;
+
+    constexpr Address end() const noexcept { return offset + width; }
+};
+
+/** A range of bytes relative to the start of an item's record. */
+struct RecordSpan {
+    Address begin;
+    Address end;
+
+    constexpr std::size_t size() const noexcept { return end - begin; }
+
+    constexpr bool contains(FieldLayout field) const noexcept
+        { return field.offset >= begin && field.end() <= end; }
+};
+
+/** @returns the smallest span covering all given fields */
+constexpr RecordSpan covering_span(std::initializer_list<FieldLayout> fields) {
+    RecordSpan rv { ~Address(0), 0 };
+    for (const auto & field : fields) {
+        rv.begin = std::min(rv.begin, field.offset);
+        rv.end   = std::max(rv.end  , field.end());
+    }
+    return rv;
+}
+
+/** One item's record, decoded straight out of bytes copied from the target
+ *  (which may hold anything around the record too), so reading a field is
+ *  a bounds check and a copy rather than a call through a MemoryReader.
+ */
+class RecordBytes {
+public:
+    RecordBytes(const ByteSpan & bytes, Address record) noexcept:
+        m_bytes(bytes), m_record(record) {}
+
+    /** @returns address of the record in the target */
+    Address address() const noexcept { return m_record; }
+
+    bool covers(FieldLayout field) const noexcept
+        { return m_bytes.contains(m_record + field.offset, field.width); }
+
+    /** @throws std::out_of_range if the bytes do not hold the whole field */
+    const uint8_t * field(FieldLayout field) const {
+        if (!covers(field)) {
+            throw std::out_of_range("RecordBytes::field: field lies outside of the bytes given.");
+        }
+        return m_bytes.data + (m_record + field.offset - m_bytes.address);
+    }
+
+    /** @returns the T at the start of the field, in the machine's byte order */
+    template <typename T>
+    T get(FieldLayout field_) const {
+        static_assert(std::is_arithmetic_v<T>, "Can only read PoD/arithmetic types.");
+        T rv;
+        std::memcpy(&rv, field(FieldLayout { field_.offset, sizeof(T) }), sizeof(T));
+        return rv;
+    }
+
+    /** Copies the whole field (field.width bytes) to buf. */
+    void copy(FieldLayout field_, void * buf) const
+        { std::memcpy(buf, field(field_), field_.width); }
+
+private:
+    ByteSpan m_bytes;
+    Address  m_record;
+};
+
+// Inventory and floor items are records in the game's heap, the item's
+// address points to the start of the record.
+namespace InventoryLayout {
+
+constexpr const FieldLayout k_owner            { 0x0E4, 1 };
+constexpr const FieldLayout k_kill_counter     { 0x0E8, 2 };
+// three code bytes, the fourth byte holds the tech level for techs
+constexpr const FieldLayout k_fullcode         { 0x0F2, 4 };
+constexpr const FieldLayout k_meseta           { 0x100, 4 };
+// xor'd with its own address
+constexpr const FieldLayout k_tool_count       { 0x104, 4 };
+constexpr const FieldLayout k_tech_type        { 0x108, 1 };
+constexpr const FieldLayout k_mag_timer        { 0x1B4, 4 };
+constexpr const FieldLayout k_frame_slots      { 0x1B8, 1 };
+constexpr const FieldLayout k_frame_dfp        { 0x1B9, 1 };
+constexpr const FieldLayout k_frame_evp        { 0x1BA, 1 };
+constexpr const FieldLayout k_mag_stats        { 0x1C0, 8 };
+// three (id, percent) pairs
+constexpr const FieldLayout k_weapon_attributes{ 0x1C8, 6 };
+// shares its place with attributes, three 16-bit words of 5-bit characters
+constexpr const FieldLayout k_esrank_name      { 0x1C8, 6 };
+constexpr const FieldLayout k_barrier_dfp      { 0x1E4, 1 };
+constexpr const FieldLayout k_barrier_evp      { 0x1E5, 1 };
+constexpr const FieldLayout k_weapon_grind     { 0x1F5, 1 };
+constexpr const FieldLayout k_weapon_special   { 0x1F6, 1 };
+
+/** every field read from any kind of item */
+constexpr const RecordSpan k_record = covering_span({
+    k_owner, k_kill_counter, k_fullcode, k_meseta, k_tool_count, k_tech_type,
+    k_mag_timer, k_frame_slots, k_frame_dfp, k_frame_evp, k_mag_stats,
+    k_weapon_attributes, k_esrank_name, k_barrier_dfp, k_barrier_evp,
+    k_weapon_grind, k_weapon_special });
+
+// spans for each kind of item, everything read by that kind including the
+// code and kill counter which all items read
+
+constexpr const RecordSpan k_weapon_span = covering_span({
+    k_kill_counter, k_fullcode, k_weapon_attributes, k_weapon_grind, k_weapon_special });
+constexpr const RecordSpan k_esrank_span = covering_span({
+    k_kill_counter, k_fullcode, k_esrank_name, k_weapon_grind, k_weapon_special });
+constexpr const RecordSpan k_frame_span = covering_span({
+    k_kill_counter, k_fullcode, k_frame_slots, k_frame_dfp, k_frame_evp });
+constexpr const RecordSpan k_barrier_span = covering_span({
+    k_kill_counter, k_fullcode, k_barrier_dfp, k_barrier_evp });
+constexpr const RecordSpan k_mag_span = covering_span({
+    k_kill_counter, k_fullcode, k_mag_timer, k_mag_stats });
+constexpr const RecordSpan k_tool_span = covering_span({
+    k_kill_counter, k_fullcode, k_tool_count });
+constexpr const RecordSpan k_tech_span = covering_span({
+    k_kill_counter, k_fullcode, k_tech_type });
+constexpr const RecordSpan k_meseta_span = covering_span({
+    k_kill_counter, k_fullcode, k_meseta });
+constexpr const RecordSpan k_plain_span = covering_span({
+    k_kill_counter, k_fullcode });
+
+static_assert(k_record.contains(k_owner) && k_record.size() == 0x113, "");
+
+} // end of InventoryLayout namespace
+
+// The bank is a header followed by a contiguous block of 24 byte records.
+namespace BankLayout {
+
+constexpr const std::size_t k_record_size = 24;
+
+// header, relative to the bank pointer
+constexpr const FieldLayout k_item_count       { 0x0, 1 };
+constexpr const FieldLayout k_bank_meseta      { 0x4, 4 };
+constexpr const Address     k_first_record     = 0x8;
+
+// relative to each record
+constexpr const FieldLayout k_fullcode         { 0x00, 4 };
+constexpr const FieldLayout k_weapon_grind     { 0x03, 1 };
+constexpr const FieldLayout k_weapon_special   { 0x04, 1 };
+constexpr const FieldLayout k_tech_type        { 0x04, 1 };
+constexpr const FieldLayout k_mag_stats        { 0x04, 8 };
+constexpr const FieldLayout k_frame_slots      { 0x05, 1 };
+constexpr const FieldLayout k_weapon_attributes{ 0x06, 6 };
+constexpr const FieldLayout k_esrank_name      { 0x06, 6 };
+constexpr const FieldLayout k_dfp              { 0x06, 1 };
+constexpr const FieldLayout k_evp              { 0x08, 1 };
+constexpr const FieldLayout k_meseta           { 0x0C, 4 };
+constexpr const FieldLayout k_tool_count       { 0x14, 1 };
+// the kill counter is read at its inventory offset, which lies well past
+// the record (so it is not part of any bank span)
+constexpr const FieldLayout k_kill_counter     = InventoryLayout::k_kill_counter;
+
+constexpr const RecordSpan k_record { 0, k_record_size };
+
+constexpr const RecordSpan k_weapon_span = covering_span({
+    k_fullcode, k_weapon_attributes, k_weapon_grind, k_weapon_special });
+constexpr const RecordSpan k_esrank_span = covering_span({
+    k_fullcode, k_esrank_name, k_weapon_grind, k_weapon_special });
+constexpr const RecordSpan k_frame_span = covering_span({
+    k_fullcode, k_frame_slots, k_dfp, k_evp });
+constexpr const RecordSpan k_barrier_span = covering_span({
+    k_fullcode, k_dfp, k_evp });
+constexpr const RecordSpan k_mag_span = covering_span({ k_fullcode, k_mag_stats });
+constexpr const RecordSpan k_tool_span = covering_span({ k_fullcode, k_tool_count });
+constexpr const RecordSpan k_tech_span = covering_span({ k_fullcode, k_tech_type });
+constexpr const RecordSpan k_meseta_span = covering_span({ k_fullcode, k_meseta });
+constexpr const RecordSpan k_plain_span = covering_span({ k_fullcode });
+
+} // end of BankLayout namespace
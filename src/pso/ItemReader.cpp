@@ -22,23 +22,42 @@
 #include "ItemReader.hpp"
 #include "ItemDb.hpp"
 #include "Item.hpp"
+#include "ItemValue.hpp"
 
 #include "../AppStateDefs.hpp"
 #include "../MemoryReader.hpp"
+#include "../ReadPlanner.hpp"
+#include "../ReadProfile.hpp"
 
 #include <iostream>
 #include <iomanip>
+#include <stdexcept>
 
 namespace {
 
-using LoadItemFunc = void (Item::*)(Address, const MemoryReader &);
+using DecodeItemFunc = void (Item::*)(const ByteSpan &, Address, const MemoryReader *);
+
+/** How one kind of record (inventory/floor or bank) is read and decoded. */
+struct RecordFormat {
+    DecodeItemFunc decode;
+    // every field read from any kind of item
+    RecordSpan     record;
+    FieldLayout    fullcode;
+};
 
 static constexpr const Address k_bank_ptr_addr     = 0x00A95DE0 + 0x18;
 static constexpr const Address k_item_ptr_to_array = 0x00A8D81C;
 static constexpr const Address k_item_array_size   = 0x00A8D820;
 static constexpr const Address k_player_index      = 0x00A9C4F4;
-static constexpr const Address k_item_owner_offset = 0xE4;
+static constexpr const Address k_item_owner_offset = InventoryLayout::k_owner.offset;
 static constexpr const int     k_no_owner          = -1;
+static constexpr const Address k_item_record_begin = InventoryLayout::k_record.begin;
+static constexpr const Address k_item_record_end   = InventoryLayout::k_record.end;
+
+const RecordFormat k_inventory_format {
+    &Item::load_from, InventoryLayout::k_record, InventoryLayout::k_fullcode };
+const RecordFormat k_bank_format {
+    &Item::load_from_bank, BankLayout::k_record, BankLayout::k_fullcode };
 
 /** Loads the entire list of item addresses including floor and inventories.
  *  @param owner_id ID number of the owner, all other items not owned by this
@@ -51,16 +70,61 @@ static constexpr const int     k_no_owner          = -1;
  *  I cannot stop you from the breaking the rules, but you may not hide in
  *  ignorance from it.
  */
-void update_item_list_for_owner(const MemoryReader &, AddressList &, int owner_id);
+void update_item_list_for_owner
+    (const MemoryReader &, const ItemGlobals &, AddressList &, int owner_id);
 
 void clean(AddressList &);
 
-uint32_t load_bank_ptr(const MemoryReader &);
-
-template <LoadItemFunc loadf>
-ItemList load_gen
+/** Decodes every item into rv (which is cleared first), either an ItemList
+ *  or an ItemValueList. Every record is read up front, in as few reads as
+ *  the planner can manage, and decoded out of those bytes.
+ */
+template <typename ListType>
+void load_gen
     (const MemoryReader & memory, const AddressList & addresses,
-     Address fullcode_offset);
+     const RecordFormat & format, ListType & rv);
+
+/** Appends the item whose record is at addr, decoded out of bytes, to rv.
+ *  @param fallback for fields outside of the bytes, it is reset first
+ *  @returns false (appending nothing) if the bytes do not hold the record,
+ *           or the item is otherwise invalid
+ */
+template <typename ListType>
+bool decode_item
+    (const ByteSpan & bytes, Address addr, const RecordFormat & format,
+     CheckedMemoryReader & fallback, ListType & rv);
+
+template <typename ListType>
+void load_bank_gen
+    (const MemoryReader &, const ItemGlobals &, const AddressList &, ListType &);
+
+/** Decodes the one item at addr into item, with buffers kept per thread.
+ *  @returns false if it could not be decoded
+ */
+bool load_single_value
+    (const MemoryReader & memory, Address addr, const RecordFormat & format,
+     ItemValue & item);
+
+/** As load_single_value, but out of bytes, with anything outside of them
+ *  read from fallback (if given).
+ */
+bool decode_single_value
+    (const ByteSpan & bytes, Address addr, const RecordFormat & format,
+     const MemoryReader * fallback, ItemValue & item);
+
+/** Runs the format's decoder on item.
+ *  @returns false if the record holds something the decoder rejects (a
+ *           special or tech code out of range, a field outside of the
+ *           bytes), as a stale or half written record may
+ */
+bool try_decode
+    (Item & item, const RecordFormat & format, const ByteSpan & bytes,
+     Address addr, const MemoryReader * fallback);
+
+/** @returns this thread's planner, so that buffers are kept between decode
+ *           passes
+ */
+ReadPlanner & decode_planner();
 
 } // end of <anonymous> namespace
 
@@ -103,65 +167,197 @@ namespace TextPalette {
 
 } // end of namespace TextPalette
 
+ItemGlobals::ItemGlobals() {
+    // why was this read as an i32?
+    m_bank         = m_resolver.add(PointerChain(k_bank_ptr_addr)
+                                    .mask(0x7FFF'FFFF).offset(0x021C));
+    m_item_array   = m_resolver.add(PointerChain(k_item_ptr_to_array));
+    m_item_count   = m_resolver.add(PointerChain(k_item_array_size, sizeof(uint8_t)));
+    m_player_index = m_resolver.add(PointerChain(k_player_index));
+}
+
+void ItemGlobals::update(const MemoryReader & memory) {
+    static ReadSite s_site("item globals");
+    ReadSiteScope scope(s_site);
+    m_resolver.update(memory);
+}
+
+// ----------------------------------------------------------------------------
+
 /* free fn */ void update_bank_pointers
-    (const MemoryReader & memory, AddressList & addresses)
+    (const MemoryReader & memory, const ItemGlobals & globals, AddressList & addresses)
 {
-    // why was this read as an i32?
-    auto bank_ptr = load_bank_ptr(memory);
+    auto bank_ptr = globals.bank_pointer();
     if (!bank_ptr) return;
 
+    static ReadSite s_site("bank pointers");
+    ReadSiteScope scope(s_site);
+    using namespace BankLayout;
     addresses.clear();
-    int count = memory.read_u8(bank_ptr);
+    if (!memory.is_readable(bank_ptr, k_first_record)) return;
+    int count = memory.read_u8(bank_ptr + k_item_count.offset);
+    if (!memory.is_readable(bank_ptr, k_first_record + k_record_size*count)) return;
     for (int i = 0; i != count; ++i) {
-        addresses.push_back(bank_ptr + 8 + 24*i);
+        addresses.push_back(bank_ptr + k_first_record + k_record_size*i);
     }
 
     clean(addresses);
 }
 
 /* free fn */ void update_inventory_pointers
-    (const MemoryReader & memory, AddressList & addresses)
-{
-    auto player_index = memory.read_u32(k_player_index);
-    update_item_list_for_owner(memory, addresses, player_index);
-}
+    (const MemoryReader & memory, const ItemGlobals & globals, AddressList & addresses)
+{ update_item_list_for_owner(memory, globals, addresses, globals.player_index()); }
 
 /* free fn */ void update_floor_pointers
-    (const MemoryReader & memory, AddressList & addresses)
-{ return update_item_list_for_owner(memory, addresses, k_no_owner); }
+    (const MemoryReader & memory, const ItemGlobals & globals, AddressList & addresses)
+{ return update_item_list_for_owner(memory, globals, addresses, k_no_owner); }
 
-/* free fn */ ItemList load_bank
-    (const MemoryReader & memory, const AddressList & addresses)
+/* free fn */ void collect_item_regions
+    (const MemoryReader & memory, MemoryRegionList & regions)
 {
-    auto rv = load_gen<&Item::load_from_bank>(memory, addresses, 0);
+    ItemGlobals globals;
+    collect_item_regions(memory, globals, regions);
+}
 
-    auto bank_ptr = load_bank_ptr(memory);
-    if (bank_ptr) {
-        auto mes = std::make_unique<Meseta>();
-        mes->set_quantity(memory.read_i32(bank_ptr + 4));
-        rv.push_back(std::move(mes));
+/* free fn */ void collect_item_regions
+    (const MemoryReader & memory, ItemGlobals & globals, MemoryRegionList & regions)
+{
+    static ReadSite s_site("item regions");
+    ReadSiteScope scope(s_site);
+    regions.push_back(MemoryRegion { k_bank_ptr_addr    , sizeof(uint32_t) });
+    regions.push_back(MemoryRegion { k_item_ptr_to_array, sizeof(uint32_t) });
+    regions.push_back(MemoryRegion { k_item_array_size  , sizeof(uint8_t ) });
+    regions.push_back(MemoryRegion { k_player_index     , sizeof(uint32_t) });
+
+    globals.update(memory);
+    if (auto bank_ptr = globals.bank_pointer()) {
+        using namespace BankLayout;
+        // the kill counter is read at its inventory offset for bank items
+        // too, which can run past the last record
+        auto count = memory.read_u8(bank_ptr + k_item_count.offset);
+        regions.push_back(MemoryRegion { bank_ptr,
+            k_first_record + k_record_size*std::size_t(count) + k_kill_counter.end() });
     }
 
+    auto item_count = globals.item_count();
+    if (!item_count) return;
+    auto item_array = globals.item_array();
+    regions.push_back(MemoryRegion { item_array, item_count*sizeof(uint32_t) });
+
+    std::array<uint32_t, 0xFF> rawptrs;
+    memory.read(item_array, reinterpret_cast<uint8_t *>(rawptrs.data()),
+                item_count*sizeof(uint32_t));
+    for (int i = 0; i != item_count; ++i) {
+        MemoryRegion record {
+            rawptrs[i] + k_item_record_begin, k_item_record_end - k_item_record_begin };
+        if (!memory.is_readable(record.address, record.length)) continue;
+        regions.push_back(record);
+    }
+}
+
+/* free fn */ ItemList load_bank
+    (const MemoryReader & memory, const ItemGlobals & globals,
+     const AddressList & addresses)
+{
+    ItemList rv;
+    load_bank_gen(memory, globals, addresses, rv);
     return rv;
 }
 
 /* free fn */ ItemList load_inventory
     (const MemoryReader & memory, const AddressList & addresses)
-{ return load_gen<&Item::load_from>(memory, addresses, k_item_code_offset); }
+{
+    ItemList rv;
+    load_gen(memory, addresses, k_inventory_format, rv);
+    return rv;
+}
 
 /* free fn */ ItemList load_floor
     (const MemoryReader & memory, const AddressList & addresses)
-{ return load_gen<&Item::load_from>(memory, addresses, k_item_code_offset); }
+{
+    ItemList rv;
+    load_gen(memory, addresses, k_inventory_format, rv);
+    return rv;
+}
+
+/* free fn */ std::unique_ptr<Item> load_inventory_item
+    (const MemoryReader & memory, Address addr)
+{
+    ItemList rv;
+    load_gen(memory, AddressList { addr }, k_inventory_format, rv);
+    return rv.empty() ? nullptr : std::move(rv.front());
+}
+
+/* free fn */ std::unique_ptr<Item> load_bank_item
+    (const MemoryReader & memory, Address addr)
+{
+    ItemList rv;
+    load_gen(memory, AddressList { addr }, k_bank_format, rv);
+    return rv.empty() ? nullptr : std::move(rv.front());
+}
+
+/* free fn */ void load_bank_values
+    (const MemoryReader & memory, const ItemGlobals & globals,
+     const AddressList & addresses, ItemValueList & items)
+{ load_bank_gen(memory, globals, addresses, items); }
+
+/* free fn */ void load_inventory_values
+    (const MemoryReader & memory, const AddressList & addresses,
+     ItemValueList & items)
+{ load_gen(memory, addresses, k_inventory_format, items); }
+
+/* free fn */ void load_floor_values
+    (const MemoryReader & memory, const AddressList & addresses,
+     ItemValueList & items)
+{ load_gen(memory, addresses, k_inventory_format, items); }
+
+/* free fn */ bool load_inventory_value
+    (const MemoryReader & memory, Address addr, ItemValue & item)
+{ return load_single_value(memory, addr, k_inventory_format, item); }
+
+/* free fn */ bool load_bank_value
+    (const MemoryReader & memory, Address addr, ItemValue & item)
+{ return load_single_value(memory, addr, k_bank_format, item); }
+
+/* free fn */ bool decode_inventory_value
+    (const ByteSpan & bytes, Address addr, ItemValue & item, const MemoryReader * fallback)
+{ return decode_single_value(bytes, addr, k_inventory_format, fallback, item); }
+
+/* free fn */ bool decode_bank_value
+    (const ByteSpan & bytes, Address addr, ItemValue & item, const MemoryReader * fallback)
+{ return decode_single_value(bytes, addr, k_bank_format, fallback, item); }
 
 void Item::load_from(Address addr, const MemoryReader & memory) {
-    uint32_t fullcode = memory.read_u32(addr + k_item_code_offset) & 0xFF'FFFF;
-    set_fullcode_and_kills(fullcode, addr, memory);
-    load_from_(addr, memory);
+    // one read for the whole span, everything after is decoded locally
+    std::array<uint8_t, InventoryLayout::k_record.size()> buf;
+    auto span = inventory_span();
+    memory.read(addr + span.begin, buf.data(), span.size());
+    load_from(ByteSpan { addr + span.begin, buf.data(), span.size() }, addr, &memory);
 }
 
 void Item::load_from_bank(Address addr, const MemoryReader & memory) {
-    set_fullcode_and_kills(memory.read_u32(addr) & 0xFF'FFFF, addr, memory);
-    load_from_bank_(addr, memory);
+    std::array<uint8_t, BankLayout::k_record.size()> buf;
+    auto span = bank_span();
+    memory.read(addr + span.begin, buf.data(), span.size());
+    load_from_bank(ByteSpan { addr + span.begin, buf.data(), span.size() }, addr, &memory);
+}
+
+void Item::load_from
+    (const ByteSpan & bytes, Address addr, const MemoryReader * fallback)
+{
+    RecordBytes record(bytes, addr);
+    address = addr;
+    set_fullcode_and_kills(record, InventoryLayout::k_fullcode, fallback);
+    load_from_(record);
+}
+
+void Item::load_from_bank
+    (const ByteSpan & bytes, Address addr, const MemoryReader * fallback)
+{
+    RecordBytes record(bytes, addr);
+    address = addr;
+    set_fullcode_and_kills(record, BankLayout::k_fullcode, fallback);
+    load_from_bank_(record);
 }
 
 /* protected */ std::ostream & Item::print_name(char default_, std::ostream & out) const {
@@ -188,14 +384,22 @@ void Item::load_from_bank(Address addr, const MemoryReader & memory) {
 /* protected */ void Item::set_name(const char * name_) { name = name_; }
 
 /* private */ void Item::set_fullcode_and_kills
-    (uint32_t fullcode, Address addr, const MemoryReader & memory)
+    (const RecordBytes & record, FieldLayout fullcode_field, const MemoryReader * fallback)
 {
     // both inventory and bank
-    static constexpr const Address k_kill_counter_offset = 0xE8;
+    uint32_t fullcode = record.get<uint32_t>(fullcode_field) & 0xFF'FFFF;
     const auto & nfo = get_item_info(fullcode);
     name = nfo.name;
     if (nfo.has_kill_counter) {
-        kills = memory.read_u16(addr + k_kill_counter_offset);
+        using InventoryLayout::k_kill_counter;
+        if (record.covers(k_kill_counter) || !fallback) {
+            kills = record.get<uint16_t>(k_kill_counter);
+        } else {
+            // lies outside of the bank's records
+            static ReadSite s_site("kill counters");
+            ReadSiteScope scope(s_site);
+            kills = fallback->read_u16(record.address() + k_kill_counter.offset);
+        }
     }
     rarity = nfo.rarity;
     this->fullcode = fullcode;
@@ -203,20 +407,164 @@ void Item::load_from_bank(Address addr, const MemoryReader & memory) {
 
 namespace {
 
-std::unique_ptr<Item> make_item(const MemoryReader &, Address);
+template <typename T>
+struct ItemKindTag { using Type = T; };
+
+/** Calls f with the ItemKindTag for the kind of item fullcode is */
+template <typename Func>
+void visit_item_kind(uint32_t fullcode, Func && f);
+
+/** Appends a default item of the kind fullcode is.
+ *  @returns the new item, for it to be loaded
+ */
+Item & emplace_item(ItemList &, uint32_t fullcode);
+Item & emplace_item(ItemValueList &, uint32_t fullcode);
+
+void append_meseta(ItemList &, int quantity);
+void append_meseta(ItemValueList &, int quantity);
+
+/** @returns this thread's buffer for bank blocks */
+std::vector<uint8_t> & bank_block_buffer();
 
-template <LoadItemFunc loadf>
-ItemList load_gen
+[[noreturn]] void throw_fatal(ReadStatus);
+
+template <typename ListType>
+void load_gen
     (const MemoryReader & memory, const AddressList & addresses,
-     Address fullcode_offset)
+     const RecordFormat & format, ListType & rv)
 {
-    ItemList rv;
+    // every record is read here, records close together as one read, and
+    // every decoder (and their helpers) reads its fields from those bytes
+    auto & planner = decode_planner();
+    planner.clear();
+    {
+    static ReadSite s_site("item records");
+    ReadSiteScope scope(s_site);
+    for (auto addr : addresses) {
+        planner.add(addr + format.record.begin, format.record.size());
+    }
+    auto status = planner.execute(memory);
+    if (is_fatal(status)) throw_fatal(status);
+    }
+
+    CheckedMemoryReader checked(memory);
+    rv.clear();
     rv.reserve(addresses.size());
+    for (std::size_t i = 0; i != addresses.size(); ++i) {
+        // the planner already retried a failed record on its own, one that
+        // still could not be read is left out
+        auto data = planner.data(i);
+        if (!data) continue;
+        auto addr = addresses[i];
+        ByteSpan bytes { addr + format.record.begin, data, format.record.size() };
+        decode_item(bytes, addr, format, checked, rv);
+    }
+}
+
+template <typename ListType>
+bool decode_item
+    (const ByteSpan & bytes, Address addr, const RecordFormat & format,
+     CheckedMemoryReader & fallback, ListType & rv)
+{
+    if (!bytes.contains(addr + format.record.begin, format.record.size())) return false;
+    RecordBytes record(bytes, addr);
+    auto & item = emplace_item(rv, record.get<uint32_t>(format.fullcode) & 0xFF'FFFF);
+    // decoders read fields outside of the bytes (the bank's kill counters)
+    // through the checked reader, which keeps a single stale item from
+    // unwinding the whole list
+    fallback.reset();
+    if (try_decode(item, format, bytes, addr, &fallback) && fallback.good())
+        { return true; }
+    rv.pop_back();
+    if (is_fatal(fallback.status())) throw_fatal(fallback.status());
+    // otherwise the item was invalid, and is left out
+    return false;
+}
+
+template <typename ListType>
+void load_bank_gen
+    (const MemoryReader & memory, const ItemGlobals & globals,
+     const AddressList & addresses, ListType & rv)
+{
+    using namespace BankLayout;
+    auto bank_ptr = globals.bank_pointer();
+    if (!bank_ptr) {
+        load_gen(memory, addresses, k_bank_format, rv);
+        return;
+    }
+
+    // header and every record are contiguous, so grab the whole block in
+    // one read and decode all items straight out of it (anything outside
+    // the block, like the kill counter, still falls through to memory)
+    auto & block = bank_block_buffer();
+    block.resize(k_first_record + k_record_size*addresses.size());
+    {
+    static ReadSite s_site("bank block");
+    ReadSiteScope scope(s_site);
+    memory.read(bank_ptr, block.data(), block.size());
+    }
+    ByteSpan bank { bank_ptr, block.data(), block.size() };
+
+    CheckedMemoryReader checked(memory);
+    rv.clear();
+    rv.reserve(addresses.size() + 1);
     for (auto addr : addresses) {
-        rv.push_back(make_item(memory, addr + fullcode_offset));
-        ((*rv.back()).*loadf)(addr, memory);
+        decode_item(bank, addr, k_bank_format, checked, rv);
     }
-    return rv;
+    append_meseta(rv, RecordBytes(bank, bank_ptr).get<int32_t>(k_bank_meseta));
+}
+
+bool load_single_value
+    (const MemoryReader & memory, Address addr, const RecordFormat & format,
+     ItemValue & item)
+{
+    thread_local AddressList   addresses(1);
+    thread_local ItemValueList loaded;
+    addresses.front() = addr;
+    load_gen(memory, addresses, format, loaded);
+    if (loaded.empty()) return false;
+    item = std::move(loaded.front());
+    return true;
+}
+
+bool decode_single_value
+    (const ByteSpan & bytes, Address addr, const RecordFormat & format,
+     const MemoryReader * fallback, ItemValue & item)
+{
+    if (!bytes.contains(addr + format.record.begin, format.record.size())) return false;
+    ItemValue rv;
+    auto fullcode = RecordBytes(bytes, addr).get<uint32_t>(format.fullcode) & 0xFF'FFFF;
+    visit_item_kind(fullcode, [&rv](auto tag) {
+        using Type = typename decltype(tag)::Type;
+        rv.emplace<Type>();
+    });
+    if (fallback) {
+        CheckedMemoryReader checked(*fallback);
+        bool decoded = std::visit([&](Item & decoded)
+            { return try_decode(decoded, format, bytes, addr, &checked); }, rv);
+        if (is_fatal(checked.status())) throw_fatal(checked.status());
+        if (!decoded || !checked.good()) return false;
+    } else {
+        bool decoded = std::visit([&](Item & decoded)
+            { return try_decode(decoded, format, bytes, addr, nullptr); }, rv);
+        if (!decoded) return false;
+    }
+    item = std::move(rv);
+    return true;
+}
+
+bool try_decode
+    (Item & item, const RecordFormat & format, const ByteSpan & bytes,
+     Address addr, const MemoryReader * fallback)
+{
+    try {
+        (item.*format.decode)(bytes, addr, fallback);
+    } catch (std::invalid_argument &) {
+        return false;
+    } catch (std::out_of_range &) {
+        return false;
+    }
+    return true;
 }
 
 // refer to rule 6 on:
@@ -225,26 +573,55 @@ ItemList load_gen
 // I cannot stop you from the breaking the rules, but you may not hide in
 // ignorance from it.
 void update_item_list_for_owner
-    (const MemoryReader & memory, AddressList & addresses, int owner_id)
+    (const MemoryReader & memory, const ItemGlobals & globals,
+     AddressList & addresses, int owner_id)
 {
+    static ReadSite s_site("owner filter");
+    ReadSiteScope scope(s_site);
     addresses.clear();
 
-    auto item_count = memory.read_u8(k_item_array_size);
+    int  item_count = globals.item_count();
+    auto item_array = globals.item_array();
     if (!item_count) return;
 
-    auto item_array = memory.read_u32(k_item_ptr_to_array);
     addresses.reserve(item_count);
 
+    // phase one: the pointer array
     std::array<uint32_t, 0xFF> rawptrs;
     memory.read(item_array, reinterpret_cast<uint8_t *>(rawptrs.data()),
                 item_count*sizeof(uint32_t));
+
+    // phase two: every owner byte in one scatter-gather read
+    std::array<int8_t, 0xFF> owners;
+    // kept from pass to pass, so that steady state passes don't allocate
+    thread_local ReadRequestList requests;
+    requests.clear();
+    requests.reserve(item_count);
     while (item_count) {
-        addresses.push_back(Address(rawptrs[--item_count]));
+        Address addr = rawptrs[--item_count];
+        // dead pointers are common during zone transitions, drop them here
+        // rather than failing the whole list on a bad read
+        if (!memory.is_readable(addr + k_item_record_begin,
+                                k_item_record_end - k_item_record_begin))
+        { continue; }
+        requests.push_back(make_read_request(addr + k_item_owner_offset, owners[addresses.size()]));
+        addresses.push_back(addr);
     }
 
-    for (auto & addr : addresses) {
-        auto item_owner_id = memory.read_i8(addr + k_item_owner_offset);
-        if (item_owner_id != owner_id) addr = k_no_address;
+    auto status = memory.try_read_batch(requests);
+    if (is_fatal(status)) throw_fatal(status);
+    if (status != ReadStatus::ok) {
+        // something went bad between checking and reading, find out which
+        for (std::size_t i = 0; i != requests.size(); ++i) {
+            const auto & req = requests[i];
+            status = memory.try_read(req.address, req.destination, req.length);
+            if (is_fatal(status)) throw_fatal(status);
+            if (status != ReadStatus::ok) addresses[i] = k_no_address;
+        }
+    }
+
+    for (std::size_t i = 0; i != addresses.size(); ++i) {
+        if (owners[i] != owner_id) addresses[i] = k_no_address;
     }
 
     clean(addresses);
@@ -256,38 +633,74 @@ void clean(AddressList & addresses) {
         addresses.end());
 }
 
-uint32_t load_bank_ptr(const MemoryReader & memory) {
-    // why was this read as an i32?
-    auto bank_ptr = memory.read_u32(k_bank_ptr_addr) & 0x7FFF'FFFF;
-    if (!bank_ptr) return 0;
-    return bank_ptr + 0x021C;
+[[noreturn]] void throw_fatal(ReadStatus status) {
+    if (status == ReadStatus::no_permission) {
+        throw PermissionError("Lost permission to read the target's memory.");
+    }
+    throw std::runtime_error("Target process is no longer readable.");
 }
 
 // ----------------------------------------------------------------------------
 
-std::unique_ptr<Item> make_item(const MemoryReader & memory, Address addr) {
-    using std::make_unique;
-    auto fullcode = memory.read_u32(addr) & 0xFFFFFF;
+ReadPlanner & decode_planner() {
+    thread_local ReadPlanner planner;
+    return planner;
+}
+
+std::vector<uint8_t> & bank_block_buffer() {
+    thread_local std::vector<uint8_t> buffer;
+    return buffer;
+}
+
+template <typename Func>
+void visit_item_kind(uint32_t fullcode, Func && f) {
     auto low  = fullcode & 0xFF;
     auto high = (fullcode >> 8) & 0xFF;
     switch (low) {
     case 0:
-        if (is_esrank(fullcode)) { return make_unique<EsWeapon>(); }
-        else                     { return make_unique<  Weapon>(); }
+        if (is_esrank(fullcode)) { return f(ItemKindTag<EsWeapon>()); }
+        else                     { return f(ItemKindTag<  Weapon>()); }
     case 1:
         switch (high) {
-        case 1 : return make_unique<Frame             >();
-        case 2 : return make_unique<Barrier           >();
-        case 3 : return make_unique<Unit              >();
-        default: return make_unique<TotallyUnknownItem>();
+        case 1 : return f(ItemKindTag<Frame             >());
+        case 2 : return f(ItemKindTag<Barrier           >());
+        case 3 : return f(ItemKindTag<Unit              >());
+        default: return f(ItemKindTag<TotallyUnknownItem>());
         }
-    case 2: return make_unique<Mag>();
+    case 2: return f(ItemKindTag<Mag>());
     case 3:
-        if (high == 2) { return make_unique<Tech>(); }
-        else           { return make_unique<Tool>(); }
-    case 4 : return make_unique<Meseta>();
-    default: return make_unique<TotallyUnknownItem>();
+        if (high == 2) { return f(ItemKindTag<Tech>()); }
+        else           { return f(ItemKindTag<Tool>()); }
+    case 4 : return f(ItemKindTag<Meseta>());
+    default: return f(ItemKindTag<TotallyUnknownItem>());
     }
 }
 
+Item & emplace_item(ItemList & items, uint32_t fullcode) {
+    visit_item_kind(fullcode, [&items](auto tag) {
+        using Type = typename decltype(tag)::Type;
+        items.push_back(std::make_unique<Type>());
+    });
+    return *items.back();
+}
+
+Item & emplace_item(ItemValueList & items, uint32_t fullcode) {
+    visit_item_kind(fullcode, [&items](auto tag) {
+        using Type = typename decltype(tag)::Type;
+        items.emplace_back(std::in_place_type<Type>);
+    });
+    return std::visit([](Item & item) -> Item & { return item; }, items.back());
+}
+
+void append_meseta(ItemList & items, int quantity) {
+    auto mes = std::make_unique<Meseta>();
+    mes->set_quantity(quantity);
+    items.push_back(std::move(mes));
+}
+
+void append_meseta(ItemValueList & items, int quantity) {
+    items.emplace_back(std::in_place_type<Meseta>);
+    std::get<Meseta>(items.back()).set_quantity(quantity);
+}
+
 } // end of <anonymous> namespace
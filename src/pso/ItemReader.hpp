@@ -22,6 +22,8 @@
 #pragma once
 
 #include "../Defs.hpp"
+#include "../PointerChain.hpp"
+#include "ItemLayout.hpp"
 
 #include <memory>
 
@@ -47,19 +49,59 @@ char interpret_rarity(Rarity, char default_);
 
 class Item;
 class MemoryReader;
+
+/** The target's globals the item readers start from, resolved through
+ *  pointer chains so that an update costs one batched read of their roots.
+ */
+class ItemGlobals {
+public:
+    ItemGlobals();
+
+    /** @throws as MemoryReader::read_batch does */
+    void update(const MemoryReader & memory);
+
+    /** @returns address of the bank block, or zero if there is none */
+    Address bank_pointer() const { return m_resolver.value(m_bank); }
+    Address item_array  () const { return m_resolver.value(m_item_array); }
+    int     item_count  () const { return int(m_resolver.value(m_item_count)); }
+    int     player_index() const { return int(m_resolver.value(m_player_index)); }
+
+private:
+    using ChainId = PointerChainResolver::ChainId;
+
+    PointerChainResolver m_resolver;
+    ChainId m_bank, m_item_array, m_item_count, m_player_index;
+};
+
 using AddressList    = std::vector<Address>;
 using ItemList       = std::vector<std::unique_ptr<Item>>;
 using ItemLoader     = ItemList(*)(const MemoryReader &, const AddressList &);
-using ItemPtrUpdater = void    (*)(const MemoryReader &, AddressList &);
+using ItemPtrUpdater = void    (*)(const MemoryReader &, const ItemGlobals &, AddressList &);
+
+void update_bank_pointers     (const MemoryReader &, const ItemGlobals &, AddressList &);
+void update_inventory_pointers(const MemoryReader &, const ItemGlobals &, AddressList &);
+void update_floor_pointers    (const MemoryReader &, const ItemGlobals &, AddressList &);
 
-void update_bank_pointers     (const MemoryReader &, AddressList &);
-void update_inventory_pointers(const MemoryReader &, AddressList &);
-void update_floor_pointers    (const MemoryReader &, AddressList &);
+/** Gathers every region of the target the item readers touch: globals, the
+ *  bank block, the item pointer array and each item's record.
+ */
+void collect_item_regions(const MemoryReader &, MemoryRegionList &);
 
-ItemList load_bank     (const MemoryReader &, const AddressList &);
+/** As above, resolving the globals with (and leaving them in) the given
+ *  globals, so that one kept between calls allocates nothing.
+ */
+void collect_item_regions(const MemoryReader &, ItemGlobals &, MemoryRegionList &);
+
+ItemList load_bank     (const MemoryReader &, const ItemGlobals &, const AddressList &);
 ItemList load_inventory(const MemoryReader &, const AddressList &);
 ItemList load_floor    (const MemoryReader &, const AddressList &);
 
+/** Decodes a single item record, for reloading just the items that changed.
+ *  @returns nullptr if the record could not be decoded
+ */
+std::unique_ptr<Item> load_inventory_item(const MemoryReader &, Address);
+std::unique_ptr<Item> load_bank_item     (const MemoryReader &, Address);
+
 class Item {
 public:
     static constexpr const int          k_has_no_kill_counter = -1;
@@ -71,16 +113,35 @@ public:
     void load_from     (Address, const MemoryReader &);
     void load_from_bank(Address, const MemoryReader &);
 
+    /** Decodes the record at the given address out of bytes already copied
+     *  from the target (a snapshot, the bank block, a capture...) without
+     *  making any reads, so bulk sources decode at the speed of memory.
+     *  The kill counter of bank items lies outside of their records, it is
+     *  read from fallback if the bytes do not hold it.
+     *  @throws std::out_of_range if the bytes miss a field this kind of item
+     *          reads (and there is no fallback for it)
+     */
+    void load_from     (const ByteSpan &, Address, const MemoryReader * fallback = nullptr);
+    void load_from_bank(const ByteSpan &, Address, const MemoryReader * fallback = nullptr);
+
     bool operator < (const Item & rhs) const noexcept
         { return order_compare_to(rhs) < 0; }
 
+    /** @returns the address of the record this item was loaded from */
+    Address source_address() const noexcept { return address; }
+
 protected:
     Rarity   rarity   = Rarity::common;
     int      kills    = k_has_no_kill_counter;
     uint32_t fullcode = 0;
 
-    virtual void load_from_     (Address, const MemoryReader &) = 0;
-    virtual void load_from_bank_(Address, const MemoryReader &) = 0;
+    virtual void load_from_     (const RecordBytes &) = 0;
+    virtual void load_from_bank_(const RecordBytes &) = 0;
+
+    // the part of the record this kind of item reads, which is fetched in
+    // one read before decoding (defaults cover every known field)
+    virtual RecordSpan inventory_span() const noexcept { return InventoryLayout::k_record; }
+    virtual RecordSpan bank_span     () const noexcept { return BankLayout     ::k_record; }
 
     std::ostream & print_name(char default_, std::ostream &) const;
     std::ostream & print_name_min(std::ostream &) const;
@@ -95,9 +156,10 @@ private:
         return int(fc) - int(ofc);
     }
 
-    const char * name = k_unknown_item;
+    const char * name    = k_unknown_item;
+    Address      address = k_no_address;
 
-    void set_fullcode_and_kills(uint32_t, Address, const MemoryReader &);
+    void set_fullcode_and_kills(const RecordBytes &, FieldLayout fullcode, const MemoryReader * fallback);
 };
 
 inline bool is_rare_tier(Rarity r)
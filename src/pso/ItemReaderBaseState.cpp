@@ -23,11 +23,18 @@
 #include "ItemReaderStates.hpp"
 #include "ProcessWatcher.hpp"
 
-#include <cmath>
-#include <cassert>
+#include "ClientWorker.hpp"
+
+#include "../MemoryReader.hpp"
+#include "../SnapshotMemoryReader.hpp"
+#include "../ReadProfile.hpp"
 
+#include <algorithm>
 #include <sstream>
 
+#include <cmath>
+#include <cassert>
+
 namespace {
 
 template <typename IterType>
@@ -38,20 +45,61 @@ IterType render_line
 
 } // end of <anonymous> namespace
 
-void ItemReaderBaseState::setup(std::shared_ptr<const MemoryReader> source) {
-    m_reader = source;
-    update_item_list();
+void ItemReaderBaseState::setup(std::shared_ptr<ClientSet> clients) {
+    m_clients = std::move(clients);
+    m_shown   = nullptr;
+    if (!m_clients || m_clients->empty()) return;
+
+    // every list is kept up to date by the client, so switching views
+    // needs no reads at all, only a client never stepped needs a first step
+    auto & client = m_clients->selected();
+    if (!client.is_started() && !client.latest_snapshot()) {
+        // permission problems are for the caller to show
+        try {
+            client.step(0.);
+        } catch (PermissionError &) {
+            throw;
+        } catch (...) {}
+    }
+    show_latest();
+}
+
+void ItemReaderBaseState::setup
+    (std::shared_ptr<const MemoryReader> source, std::shared_ptr<CaptureWriter> capture)
+{
+    auto clients = std::make_shared<ClientSet>();
+    if (source) {
+        std::stringstream label;
+        source->describe_source(label);
+        clients->add(std::make_shared<ClientWorker>
+            (std::move(source), label.str(), std::move(capture)));
+    }
+    setup(std::move(clients));
 }
 
 void ItemReaderBaseState::handle_event(const Event & event) {
-    auto scroll = [this](int step) {
+    const int item_count = m_shown ? int(m_shown->item_strings.size()) : 0;
+    auto scroll = [this, item_count](int step) {
         m_line_offset += step;
+        if (m_line_offset >= item_count)
+            { m_line_offset = item_count - 1; }
         if (m_line_offset < 0)
             { m_line_offset = 0; }
-        else if (m_line_offset >= int(m_item_strings.size()))
-            { m_line_offset = int(m_item_strings.size()) - 1; }
     };
-    if (auto * sp = event.as_pointer<SpecialKey>()) {
+    if (auto * tp = event.as_pointer<TextEvent>()) {
+        switch (tp->code) {
+        case 's': if (source()) save_snapshot(); break;
+        case 'p': dump_read_profile(); break;
+        // clients are numbered from one, as the keys are laid out
+        case '1': case '2': case '3': case '4': case '5':
+        case '6': case '7': case '8': case '9':
+            select_client(std::size_t(tp->code - '1'));
+            break;
+        case '[': select_next_client(-1); break;
+        case ']': select_next_client( 1); break;
+        default: break;
+        }
+    } else if (auto * sp = event.as_pointer<SpecialKey>()) {
         switch (*sp) {
         case SpecialKey::escape   : throw QuitAppException();
         case SpecialKey::up       : scroll(-1); break;
@@ -59,10 +107,10 @@ void ItemReaderBaseState::handle_event(const Event & event) {
         case SpecialKey::page_up  : scroll(-m_page_step); break;
         case SpecialKey::page_down: scroll( m_page_step); break;
         case SpecialKey::left:
-            change_state_to_id(this_state_id() - 1).setup(m_reader);
+            change_state_to_id(this_state_id() - 1).setup(m_clients);
             break;
         case SpecialKey::right:
-            change_state_to_id(this_state_id() + 1).setup(m_reader);
+            change_state_to_id(this_state_id() + 1).setup(m_clients);
             break;
         default: break;
         }
@@ -70,27 +118,40 @@ void ItemReaderBaseState::handle_event(const Event & event) {
 }
 
 void ItemReaderBaseState::handle_tick(double et) {
+    if (!m_clients) return;
+
     if ( (m_delay += et) >= k_max_delay ) {
         m_delay = std::fmod(m_delay, k_max_delay);
         m_delay_counter = (m_delay_counter + 1) % 8;
         assert(m_delay_counter >= 0);
-
-        update_item_strings();
     }
 
-    m_pointers.clear();
-    try {
-        load_addresses(*m_reader, m_pointers);
-        if (!std::equal(m_pointers    .begin(), m_pointers    .end(),
-                        m_old_pointers.begin(), m_old_pointers.end()))
-        {
-            m_items = load_items(*m_reader, m_pointers);
-            update_item_strings();
-            m_old_pointers = m_pointers;
+    if (!m_clients->empty()) {
+        auto & client = m_clients->selected();
+        if (!client.is_started()) {
+            // a throw stops the client (and sets its status), which is
+            // dropped below
+            try {
+                client.step(et);
+            } catch (...) {}
         }
-    }  catch (...) {
+    }
+    bool lost_permission = false;
+    if (m_clients->remove_stopped(lost_permission)) {
+        m_shown = nullptr;
+    }
+    if (lost_permission) {
+        // permission is the same for every client, so the watcher says
+        // how to get it back
+        switch_state<PsobbProcessWatcher>().report_bad_permission();
+        return;
+    }
+    if (m_clients->empty()) {
         switch_state<PsobbProcessWatcher>();
+        return;
     }
+    look_for_new_clients(et);
+    show_latest();
 }
 
 void ItemReaderBaseState::handle_resize(const GridSize & gsize) {
@@ -116,20 +177,21 @@ void ItemReaderBaseState::handle_resize(const GridSize & gsize) {
     header_line += sizestr + lastpart;
 }
 
-/* protected */ void ItemReaderBaseState::update_item_list() {
-    if (!m_reader) return;
-
-    try {
-        m_old_pointers = m_pointers;
-        m_pointers.clear();
-        load_addresses(*m_reader, m_pointers);
-        m_items = load_items(*m_reader, m_pointers);
-
-        update_item_strings();
-    } catch (PermissionError &) {
-        throw;
-    } catch (...) {
-        switch_state<PsobbProcessWatcher>();
+/* protected */ void ItemReaderBaseState::render_header
+    (TargetGrid & target, const std::string & header) const
+{
+    if (m_clients && m_clients->size() > 1) {
+        auto line = header + " < "
+            + std::to_string(m_clients->selected_index() + 1) + "/"
+            + std::to_string(m_clients->size()) + " "
+            + m_clients->selected().label() + " >";
+        if (target.width() >= int(line.size())) {
+            render_string_centered(target, line, 0, TargetGrid::k_highlight_colors);
+            return;
+        }
+    }
+    if (target.width() >= int(header.size())) {
+        render_string_centered(target, header, 0, TargetGrid::k_highlight_colors);
     }
 }
 
@@ -142,11 +204,21 @@ void ItemReaderBaseState::handle_resize(const GridSize & gsize) {
     if (end_line < start_line) {
         throw std::invalid_argument("ItemReaderBaseState::render_item_list: end_line must be less than or equal to start_line.");
     }
-    if (start_line == end_line) return;
+    if (start_line == end_line || !m_shown) return;
+    const auto & strings = m_shown->item_strings;
+    auto offset = std::min(m_line_offset, int(strings.size()));
+    render_marked_up_lines(target, start_line, end_line,
+                           strings.begin() + offset, strings.end());
+}
+
+/* protected */ void ItemReaderBaseState::render_marked_up_lines
+    (TargetGrid & target, int start_line, int end_line,
+     std::vector<std::pmr::string>::const_iterator beg,
+     std::vector<std::pmr::string>::const_iterator end) const
+{
     int line = start_line;
     std::string outs, colors;
-    auto itr = m_item_strings.begin() + m_line_offset;
-    for (; itr != m_item_strings.end(); ++itr) {
+    for (auto itr = beg; itr != end; ++itr) {
         if (line >= end_line) break;
         int x = 0;
         outs.clear();
@@ -163,32 +235,67 @@ void ItemReaderBaseState::handle_resize(const GridSize & gsize) {
     }
 }
 
-/* private */ void ItemReaderBaseState::update_item_strings() {
-    std::stringstream ssout;
-    for (auto & item : m_items) {
-        item->print_to(ssout);
-        ssout << "\n";
+/* protected */ std::shared_ptr<const MemoryReader> ItemReaderBaseState::source() const {
+    if (!m_clients || m_clients->empty()) return nullptr;
+    return m_clients->selected().source();
+}
+
+/* protected */ const AddressList & ItemReaderBaseState::item_addresses() const noexcept {
+    static const AddressList k_no_addresses;
+    return m_shown ? m_shown->addresses : k_no_addresses;
+}
+
+/* private */ void ItemReaderBaseState::look_for_new_clients(double et) {
+    // offline sources have nothing more to find
+    if (!m_clients->has_live_clients()) return;
+    if ( (m_rescan_delay += et) < k_rescan_interval ) return;
+    m_rescan_delay = 0.;
+    try {
+        attach_new_clients(*m_clients);
+    } catch (std::exception &) {
+        // a client refusing us can wait for the next look, those already
+        // attached are still fine
     }
+}
 
-    auto output = ssout.str();
-    m_item_strings.clear();
-    for_split<is_newline>(output.data(), output.data() + output.size(),
-        [this](const char * beg, const char * end)
-    { m_item_strings.push_back(std::string(beg, end)); });
+/* private */ void ItemReaderBaseState::show_latest() {
+    auto latest = m_clients->selected().latest(list_kind());
+    if (!latest || latest == m_shown) return;
 
-    m_line_offset = std::min(int(m_item_strings.size()), m_line_offset);
+    m_shown = std::move(latest);
+    m_line_offset = std::min(int(m_shown->item_strings.size()), m_line_offset);
+    update_header(m_shown->item_count);
 }
 
-// ----------------------------------------------------------------------------
+/* private */ void ItemReaderBaseState::select_client(std::size_t index) {
+    if (index >= m_clients->size() || index == m_clients->selected_index()) return;
+    m_clients->select(index);
+    m_shown = nullptr;
+    m_line_offset = 0;
+    show_latest();
+}
 
-/* private */ void SecondlyUpdatingItemReader::handle_tick(double et) {
-    ItemReaderBaseState::handle_tick(et);
-    if ((m_delay += et) > k_update_inv_delay) {
-        m_delay = std::fmod(m_delay, k_update_inv_delay);
-        update_item_list();
+/* private */ void ItemReaderBaseState::select_next_client(int step) {
+    if (m_clients->size() < 2) return;
+    auto count = int(m_clients->size());
+    auto index = ((int(m_clients->selected_index()) + step) % count + count) % count;
+    select_client(std::size_t(index));
+}
+
+/* private */ void ItemReaderBaseState::save_snapshot() {
+    static constexpr const char * const k_snapshot_filename = "snapshot.apir";
+    // exactly what's on screen, and no reads of the target needed
+    auto snapshot = m_clients->selected().latest_snapshot();
+    if (!snapshot) return;
+    try {
+        write_snapshot(k_snapshot_filename, *snapshot, snapshot->regions());
+    } catch (...) {
+        // nothing useful to do but try again later
     }
 }
 
+// ----------------------------------------------------------------------------
+
 namespace {
 
 template <typename IterType>
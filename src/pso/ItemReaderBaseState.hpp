@@ -21,18 +21,32 @@
 
 #pragma once
 
-#include "ItemReader.hpp"
+#include "ItemTracker.hpp"
 #include "../AppStateDefs.hpp"
 
+#include <memory_resource>
+
 class MemoryReader;
+class CaptureWriter;
+class ClientSet;
+struct PublishedItems;
 
 class InventoryViewState;
 class FloorViewState;
 class BankViewState;
 
+/** Shows a list of items published by the selected client's worker, and lets
+ *  the user switch between clients as well as between lists.
+ */
 class ItemReaderBaseState : public AppState {
 public:
-    void setup(std::shared_ptr<const MemoryReader>);
+    void setup(std::shared_ptr<ClientSet>);
+
+    /** Shows a single client, updated on the UI thread every tick.
+     *  @param capture if given, every tick's item regions are added to it
+     */
+    void setup(std::shared_ptr<const MemoryReader>,
+               std::shared_ptr<CaptureWriter> capture = nullptr);
 
     void handle_event(const Event &) override;
 
@@ -46,23 +60,55 @@ public:
         (std::string &, const char * firstpart, int quantity, int padding, const char * lastpart);
 
 protected:
-    using ItemPtr = std::unique_ptr<Item>;
     using ReaderStates = TypeList<InventoryViewState, FloorViewState, BankViewState>;
 
-    void update_item_list();
+    virtual const ItemListKind & list_kind() const noexcept = 0;
 
-    virtual ItemList load_items    (const MemoryReader &, const AddressList &) = 0;
-    virtual void     load_addresses(const MemoryReader &,       AddressList &) = 0;
+    /** Called whenever a newly published list is shown. */
+    virtual void update_header(int item_count) = 0;
 
     virtual std::size_t this_state_id() const noexcept = 0;
 
+    /** Renders the header on the first line, followed by which client is
+     *  shown if there's more than one (and room enough).
+     */
+    void render_header(TargetGrid &, const std::string & header) const;
+
     void render_item_list(TargetGrid &, int start_line, int end_line) const;
 
-    static bool lhs_code_lt_rhs(const ItemPtr & lhs, const ItemPtr & rhs)
-        { return *lhs < *rhs; }
+    /** Renders lines written in the items' color markup, one per grid line,
+     *  from start_line up to (not including) end_line.
+     */
+    void render_marked_up_lines
+        (TargetGrid &, int start_line, int end_line,
+         std::vector<std::pmr::string>::const_iterator beg,
+         std::vector<std::pmr::string>::const_iterator end) const;
+
+    /** @returns the selected client's uncached reader (safe to use from any
+     *           thread), nullptr if there is no client
+     */
+    std::shared_ptr<const MemoryReader> source() const;
+
+    /** @returns addresses of the items currently listed */
+    const AddressList & item_addresses() const noexcept;
 
 private:
-    void update_item_strings();
+    /** Shows the selected client's latest list, if it's new and of this
+     *  view's kind.
+     */
+    void show_latest();
+
+    void select_client(std::size_t index);
+
+    void select_next_client(int step);
+
+    /** Every so often, attaches clients started since the set was (only if
+     *  it reads live processes).
+     */
+    void look_for_new_clients(double elapsed_time);
+
+    /** Writes the selected client's last tick snapshot to "snapshot.apir" */
+    void save_snapshot();
 
     template <typename ... Types>
     ItemReaderBaseState & change_state_to_id(int id, TypeList<Types...>);
@@ -70,13 +116,9 @@ private:
     template <typename ... Types>
     ItemReaderBaseState & change_state_to_id(int id);
 
-    std::vector<std::string> m_item_strings;
-
-    std::vector<Address> m_pointers;
-    std::vector<Address> m_old_pointers;
-    std::vector<ItemPtr> m_items;
-
-    std::shared_ptr<const MemoryReader> m_reader = nullptr;
+    // the set is handed along to whichever view we switch to
+    std::shared_ptr<ClientSet> m_clients;
+    std::shared_ptr<const PublishedItems> m_shown;
 
     int m_line_offset = 0;
 
@@ -84,15 +126,9 @@ private:
     double m_delay      = 0.;
     int m_delay_counter = 0;
     int m_page_step     = 0;
-};
-
-// ----------------------------------------------------------------------------
-
-class SecondlyUpdatingItemReader : public ItemReaderBaseState {
-    void handle_tick(double) final;
 
-    static constexpr const double k_update_inv_delay = 1.;
-    double m_delay = 0.;
+    static constexpr const double k_rescan_interval = 1.;
+    double m_rescan_delay = 0.;
 };
 
 // ----------------------------------------------------------------------------
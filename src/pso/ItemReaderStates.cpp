@@ -20,68 +20,137 @@
 *****************************************************************************/
 
 #include "ItemReaderStates.hpp"
+#include "ItemValue.hpp"
+
+#include "../MemoryReader.hpp"
+
+#include <sstream>
+
+#include <cstdlib>
+
+namespace {
+
+/** @returns sampling rate in Hz from APIR_SAMPLE_RATE, zero or less turns
+ *           the sampler off
+ */
+double get_sample_rate();
+
+} // end of <anonymous> namespace
 
 void InventoryViewState::render_to(TargetGrid & target) const {
-    if (target.width() >= int(m_header_string.size())) {
-        render_string_centered(target, m_header_string, 0, TargetGrid::k_highlight_colors);
-    }
+    render_header(target, m_header_string);
     render_item_list(target, 1, target.height());
 }
 
-/* private */ ItemList InventoryViewState::load_items
-    (const MemoryReader & memory, const AddressList & addresses)
-{
-    auto rv = load_inventory(memory, addresses);
-    std::sort(rv.begin(), rv.end(), lhs_code_lt_rhs);
-
-    setup_header_line(m_header_string, "--- Inventory ", rv.size(), 2, " / 30 ---");
-    return rv;
+/* private */ void InventoryViewState::update_header(int item_count) {
+    setup_header_line(m_header_string, "--- Inventory ", item_count, 2, " / 30 ---");
 }
 
 // ----------------------------------------------------------------------------
 
 void BankViewState::render_to(TargetGrid & target) const {
-    if (target.width() >= int(m_header_string.size())) {
-        render_string_centered(target, m_header_string, 0, TargetGrid::k_highlight_colors);
-    }
+    render_header(target, m_header_string);
     render_item_list(target, 1, target.height());
 }
 
-/* private */ ItemList BankViewState::load_items
-    (const MemoryReader & memory, const AddressList & addresses)
-{
-    auto rv = load_bank(memory, addresses);
-    std::sort(rv.begin(), rv.end(), lhs_code_lt_rhs);
-
+/* private */ void BankViewState::update_header(int item_count) {
     // there is always one item for meseta, but does not count toward the
     // bank's capacity
-    setup_header_line(m_header_string, "--- Bank ", rv.size() - 1, 3, " / 200 ---");
-    return rv;
+    setup_header_line(m_header_string, "--- Bank ", std::max(0, item_count - 1), 3, " / 200 ---");
 }
 
 // ----------------------------------------------------------------------------
 
 void FloorViewState::render_to(TargetGrid & target) const {
-    if (target.width() >= int(m_header_string.size())) {
-        render_string_centered(target, m_header_string, 0, TargetGrid::k_highlight_colors);
-    }
-    render_item_list(target, 1, target.height());
+    static const std::string k_missed_header = "--- Missed ---";
+    render_header(target, m_header_string);
+    int missed_lines = m_missed_strings.empty() ? 0 : int(m_missed_strings.size()) + 1;
+    int list_end = std::max(1, target.height() - missed_lines);
+    render_item_list(target, 1, list_end);
+    if (missed_lines == 0 || list_end >= target.height()) return;
+
+    render_string_centered(target, k_missed_header, list_end, TargetGrid::k_highlight_colors);
+    render_marked_up_lines(target, list_end + 1, target.height(),
+                           m_missed_strings.begin(), m_missed_strings.end());
+}
+
+void FloorViewState::handle_tick(double et) {
+    ensure_sampler();
+    ItemReaderBaseState::handle_tick(et);
+    drain_sampler();
+}
+
+/* private */ void FloorViewState::update_header(int item_count) {
+    setup_header_line(m_header_string, "--- Floor ", item_count, 3,
+                      item_count == 1 ? " item ---" : " items ---");
 }
 
-/* private */ ItemList FloorViewState::load_items
-    (const MemoryReader & memory, const AddressList & addresses)
-{
-    auto rv = load_floor(memory, addresses);
-    std::reverse(rv.begin(), rv.end());
+/* private */ void FloorViewState::ensure_sampler() {
+    auto memory = source();
+    if (!memory) return;
+    if (m_sampler && &m_sampler->source() == memory.get()) return;
+
+    m_sampler = nullptr;
+    m_sampled_records.clear();
+    auto rate = get_sample_rate();
+    if (rate <= 0.) return;
+    // globals are kept by the sampler thread, apart from the UI's
+    auto globals = std::make_shared<ItemGlobals>();
+    m_sampler = std::make_unique<MemorySampler>(std::move(memory),
+        [globals](const MemoryReader & memory, MemoryRegionList & regions)
+    {
+        using InventoryLayout::k_record;
+        AddressList addresses;
+        globals->update(memory);
+        update_floor_pointers(memory, *globals, addresses);
+        for (auto addr : addresses) {
+            regions.push_back(MemoryRegion { addr + k_record.begin, k_record.size() });
+        }
+    }, rate);
+}
 
-    setup_header_line(m_header_string, "--- Floor ", rv.size(), 3,
-                      rv.size() == 1 ? " item ---" : " items ---");
-    return rv;
+/* private */ void FloorViewState::drain_sampler() {
+    if (!m_sampler) return;
+    using InventoryLayout::k_record;
+    // only the latest contents of each record matters
+    m_sampler->drain([this](SampleDelta && delta) {
+        if (delta.bytes.empty()) return;
+        m_sampled_records[delta.address - k_record.begin] = std::move(delta.bytes);
+    });
+
+    const auto & current = item_addresses();
+    auto was_listed = [](const AddressList & list, Address addr)
+        { return std::find(list.begin(), list.end(), addr) != list.end(); };
+    for (auto itr = m_sampled_records.begin(); itr != m_sampled_records.end(); ) {
+        auto addr = itr->first;
+        if (was_listed(current, addr)) {
+            ++itr;
+            continue;
+        }
+        if (!was_listed(m_shown_addresses, addr)) {
+            const auto & bytes = itr->second;
+            ByteSpan record { addr + k_record.begin, bytes.data(), bytes.size() };
+            ItemValue item;
+            if (decode_inventory_value(record, addr, item, nullptr)) {
+                std::stringstream ssout;
+                print_item(ssout, item);
+                m_missed_strings.emplace(m_missed_strings.begin(), ssout.str());
+                if (m_missed_strings.size() > k_max_missed_items) {
+                    m_missed_strings.pop_back();
+                }
+            }
+        }
+        itr = m_sampled_records.erase(itr);
+    }
+    m_shown_addresses = current;
 }
 
-/* private */ void FloorViewState::load_addresses
-    (const MemoryReader & memory, AddressList & addresses)
-{
-    update_floor_pointers(memory, addresses);
-    std::reverse(addresses.begin(), addresses.end());
+namespace {
+
+double get_sample_rate() {
+    const char * rate = std::getenv("APIR_SAMPLE_RATE");
+    if (!rate) return MemorySampler::k_default_rate;
+    return std::atof(rate);
 }
+
+} // end of <anonymous> namespace
@@ -22,19 +22,20 @@
 #pragma once
 
 #include "ItemReaderBaseState.hpp"
+#include "../MemorySampler.hpp"
 
 #include <unordered_set>
+#include <algorithm>
 
-class InventoryViewState final : public SecondlyUpdatingItemReader {
+class InventoryViewState final : public ItemReaderBaseState {
 public:
     void render_to(TargetGrid &) const override;
 
 private:
-    ItemList load_items
-        (const MemoryReader & memory, const AddressList & addresses) override;
+    const ItemListKind & list_kind() const noexcept override
+        { return ItemListKind::inventory(); }
 
-    void load_addresses(const MemoryReader & memory, AddressList & addresses) override
-        { update_inventory_pointers(memory, addresses); }
+    void update_header(int item_count) override;
 
     std::size_t this_state_id() const noexcept override
         { return ReaderStates::GetTypeId<InventoryViewState>::k_value; }
@@ -42,16 +43,15 @@ private:
     std::string m_header_string;
 };
 
-class BankViewState final : public SecondlyUpdatingItemReader {
+class BankViewState final : public ItemReaderBaseState {
 public:
     void render_to(TargetGrid &) const override;
 
 private:
-    ItemList load_items
-        (const MemoryReader & memory, const AddressList & addresses) override;
+    const ItemListKind & list_kind() const noexcept override
+        { return ItemListKind::bank(); }
 
-    void load_addresses(const MemoryReader & memory, AddressList & addresses) override
-        { update_bank_pointers(memory, addresses); }
+    void update_header(int item_count) override;
 
     std::size_t this_state_id() const noexcept override
         { return ReaderStates::GetTypeId<BankViewState>::k_value; }
@@ -63,14 +63,35 @@ class FloorViewState final : public ItemReaderBaseState {
 public:
     void render_to(TargetGrid &) const override;
 
+    void handle_tick(double) override;
+
 private:
-    ItemList load_items
-        (const MemoryReader & memory, const AddressList & addresses) override;
+    static constexpr const std::size_t k_max_missed_items = 5;
+
+    /** Starts (or restarts) the sampler if it doesn't sample the selected
+     *  client's source.
+     */
+    void ensure_sampler();
+
+    /** Decodes items the sampler saw, but which came and went between
+     *  ticks.
+     */
+    void drain_sampler();
 
-    void load_addresses(const MemoryReader & memory, AddressList & addresses) override;
+    const ItemListKind & list_kind() const noexcept override
+        { return ItemListKind::floor(); }
+
+    void update_header(int item_count) override;
 
     std::size_t this_state_id() const noexcept override
         { return ReaderStates::GetTypeId<FloorViewState>::k_value; }
 
     std::string m_header_string;
+
+    // polls floor item records far more often than the UI ticks, so drops
+    // that are picked up quickly still show up
+    std::unique_ptr<MemorySampler> m_sampler;
+    std::unordered_map<Address, std::vector<uint8_t>> m_sampled_records;
+    std::vector<std::pmr::string> m_missed_strings;
+    AddressList m_shown_addresses;
 };
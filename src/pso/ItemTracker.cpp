@@ -0,0 +1,344 @@
+/****************************************************************************
+
+    File: ItemTracker.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include "ItemTracker.hpp"
+#include "Item.hpp"
+
+#include "../MemoryReader.hpp"
+#include "../ReadProfile.hpp"
+
+#include <algorithm>
+#include <ostream>
+
+#include <cmath>
+
+namespace {
+
+bool lhs_code_lt_rhs(const ItemValue & lhs, const ItemValue & rhs)
+    { return as_item(lhs) < as_item(rhs); }
+
+/** Writes a stream out to the end of a string, which keeps its storage. */
+class StringWriter final : public std::streambuf {
+public:
+    explicit StringWriter(std::string & target): m_target(target) {}
+
+protected:
+    int_type overflow(int_type ch) override;
+
+    std::streamsize xsputn(const char * str, std::streamsize count) override;
+
+private:
+    std::string & m_target;
+};
+
+class InventoryKind final : public ItemListKind {
+    void load_addresses
+        (const MemoryReader & memory, const ItemGlobals & globals, AddressList & addresses) const override
+        { update_inventory_pointers(memory, globals, addresses); }
+
+    void load_items
+        (const MemoryReader &, const ItemGlobals &, const AddressList &,
+         ItemValueList &) const override;
+
+    bool decode_item
+        (const ByteSpan & record, Address addr, const MemoryReader & memory,
+         ItemValue & item) const override
+        { return decode_inventory_value(record, addr, item, &memory); }
+
+    RecordSpan record_span() const noexcept override
+        { return InventoryLayout::k_record; }
+};
+
+class FloorKind final : public ItemListKind {
+    void load_addresses
+        (const MemoryReader &, const ItemGlobals &, AddressList &) const override;
+
+    void load_items
+        (const MemoryReader &, const ItemGlobals &, const AddressList &,
+         ItemValueList &) const override;
+
+    bool decode_item
+        (const ByteSpan & record, Address addr, const MemoryReader & memory,
+         ItemValue & item) const override
+        { return decode_inventory_value(record, addr, item, &memory); }
+
+    RecordSpan record_span() const noexcept override
+        { return InventoryLayout::k_record; }
+
+    // newest first
+    bool in_reverse_address_order() const noexcept override { return true; }
+};
+
+// bank meseta and kill counters lie outside the hashed records, and so still
+// need a periodic full reload
+class BankKind final : public ItemListKind {
+    void load_addresses
+        (const MemoryReader & memory, const ItemGlobals & globals, AddressList & addresses) const override
+        { update_bank_pointers(memory, globals, addresses); }
+
+    void load_items
+        (const MemoryReader &, const ItemGlobals &, const AddressList &,
+         ItemValueList &) const override;
+
+    bool decode_item
+        (const ByteSpan & record, Address addr, const MemoryReader & memory,
+         ItemValue & item) const override
+        { return decode_bank_value(record, addr, item, &memory); }
+
+    RecordSpan record_span() const noexcept override
+        { return BankLayout::k_record; }
+
+    double full_reload_interval() const noexcept override { return 1.; }
+};
+
+} // end of <anonymous> namespace
+
+/* static */ const ItemListKind & ItemListKind::inventory() {
+    static const InventoryKind inst;
+    return inst;
+}
+
+/* static */ const ItemListKind & ItemListKind::floor() {
+    static const FloorKind inst;
+    return inst;
+}
+
+/* static */ const ItemListKind & ItemListKind::bank() {
+    static const BankKind inst;
+    return inst;
+}
+
+// ----------------------------------------------------------------------------
+
+ItemTracker::ItemTracker(const ItemListKind & kind):
+    m_kind(&kind)
+{}
+
+bool ItemTracker::update
+    (const MemoryReader & memory, const ItemGlobals & globals, double et)
+{
+    if (!m_loaded) {
+        reload(memory, globals);
+        return true;
+    }
+    auto interval = m_kind->full_reload_interval();
+    if (interval > 0. && (m_since_reload += et) > interval) {
+        m_since_reload = std::fmod(m_since_reload, interval);
+        reload(memory, globals);
+        return true;
+    }
+
+    m_pointers.clear();
+    m_kind->load_addresses(memory, globals, m_pointers);
+    return reload_changed_items(memory, globals);
+}
+
+void ItemTracker::reload(const MemoryReader & memory, const ItemGlobals & globals) {
+    m_pointers.clear();
+    m_kind->load_addresses(memory, globals, m_pointers);
+    reload_all_items(memory, globals);
+    m_loaded = true;
+}
+
+/* private */ void ItemTracker::reload_all_items
+    (const MemoryReader & memory, const ItemGlobals & globals)
+{
+    m_kind->load_items(memory, globals, m_pointers, m_loaded_items);
+
+    // loaded in display order, every item is formatted anew as not all of
+    // what's printed need be in the hashed records
+    ++m_generation;
+    m_order.clear();
+    for (auto & item : m_loaded_items) {
+        auto addr = as_item(item).source_address();
+        m_order.push_back(&cache_item(addr, std::move(item), 0));
+    }
+    // left unhashed, every item is decoded anew next update
+    if (hash_records(memory)) {
+        for (std::size_t i = 0; i != m_pointers.size(); ++i) {
+            auto itr = m_cache.find(m_pointers[i]);
+            if (itr != m_cache.end()) itr->second.record_hash = m_record_hashes[i];
+        }
+    }
+    drop_unlisted_items();
+}
+
+/* private */ bool ItemTracker::reload_changed_items
+    (const MemoryReader & memory, const ItemGlobals & globals)
+{
+    if (!hash_records(memory)) {
+        // something moved or vanished from under us, let load_items sort out
+        // which items are still good
+        reload_all_items(memory, globals);
+        return true;
+    }
+
+    ++m_generation;
+    // the bank's meseta has no record, and only comes and goes with full
+    // reloads
+    auto meseta = m_cache.find(k_no_address);
+    if (meseta != m_cache.end()) meseta->second.generation = m_generation;
+
+    bool changed = false;
+    ItemValue item;
+    auto span = m_kind->record_span();
+    for (std::size_t i = 0; i != m_pointers.size(); ++i) {
+        auto addr = m_pointers[i];
+        auto itr  = m_cache.find(addr);
+        if (itr != m_cache.end() && itr->second.record_hash == m_record_hashes[i]) {
+            itr->second.generation = m_generation;
+            continue;
+        }
+        changed = true;
+        // decoded straight out of the bytes just hashed, rather than read
+        // again, items which can't be decoded are left out as a full load
+        // would leave them
+        ByteSpan record { addr + span.begin, m_record_planner.data(i), span.size() };
+        if (!m_kind->decode_item(record, addr, memory, item)) continue;
+        if (itr != m_cache.end()) unplace_item(itr->second);
+        place_item(cache_item(addr, std::move(item), m_record_hashes[i]));
+    }
+    changed = drop_unlisted_items() || changed;
+
+    if (changed && m_kind->in_reverse_address_order()) reorder_by_address();
+    return changed;
+}
+
+/* private */ bool ItemTracker::hash_records(const MemoryReader & memory) {
+    static ReadSite s_site("record hashes");
+    ReadSiteScope scope(s_site);
+    auto span = m_kind->record_span();
+    m_record_planner.clear();
+    for (auto addr : m_pointers) {
+        m_record_planner.add(addr + span.begin, span.size());
+    }
+    if (m_record_planner.execute(memory) != ReadStatus::ok) {
+        return false;
+    }
+
+    m_record_hashes.clear();
+    for (std::size_t i = 0; i != m_pointers.size(); ++i) {
+        m_record_hashes.push_back(hash_bytes(m_record_planner.data(i), span.size()));
+    }
+    return true;
+}
+
+/* private */ TrackedItem & ItemTracker::cache_item
+    (Address addr, ItemValue && item, uint64_t record_hash)
+{
+    auto & tracked = m_cache[addr];
+    tracked.item        = std::move(item);
+    tracked.record_hash = record_hash;
+    tracked.generation  = m_generation;
+
+    tracked.line.clear();
+    StringWriter writer(tracked.line);
+    std::ostream out(&writer);
+    print_item(out, tracked.item);
+    return tracked;
+}
+
+/* private */ bool ItemTracker::drop_unlisted_items() {
+    bool dropped = false;
+    for (auto itr = m_cache.begin(); itr != m_cache.end(); ) {
+        if (itr->second.generation == m_generation) {
+            ++itr;
+            continue;
+        }
+        unplace_item(itr->second);
+        itr = m_cache.erase(itr);
+        dropped = true;
+    }
+    return dropped;
+}
+
+/* private */ void ItemTracker::place_item(const TrackedItem & tracked) {
+    // redone all at once, after every item is in
+    if (m_kind->in_reverse_address_order()) return;
+    auto pos = std::upper_bound(m_order.begin(), m_order.end(), &tracked,
+        [](const TrackedItem * lhs, const TrackedItem * rhs)
+        { return lhs_code_lt_rhs(lhs->item, rhs->item); });
+    m_order.insert(pos, &tracked);
+}
+
+/* private */ void ItemTracker::unplace_item(const TrackedItem & tracked) {
+    auto itr = std::find(m_order.begin(), m_order.end(), &tracked);
+    if (itr != m_order.end()) m_order.erase(itr);
+}
+
+/* private */ void ItemTracker::reorder_by_address() {
+    m_order.clear();
+    for (auto ritr = m_pointers.rbegin(); ritr != m_pointers.rend(); ++ritr) {
+        auto itr = m_cache.find(*ritr);
+        if (itr == m_cache.end() || itr->second.generation != m_generation) continue;
+        m_order.push_back(&itr->second);
+    }
+}
+
+namespace {
+
+void InventoryKind::load_items
+    (const MemoryReader & memory, const ItemGlobals &, const AddressList & addresses,
+     ItemValueList & items) const
+{
+    load_inventory_values(memory, addresses, items);
+    std::sort(items.begin(), items.end(), lhs_code_lt_rhs);
+}
+
+void FloorKind::load_addresses
+    (const MemoryReader & memory, const ItemGlobals & globals, AddressList & addresses) const
+{
+    update_floor_pointers(memory, globals, addresses);
+    std::reverse(addresses.begin(), addresses.end());
+}
+
+void FloorKind::load_items
+    (const MemoryReader & memory, const ItemGlobals &, const AddressList & addresses,
+     ItemValueList & items) const
+{
+    load_floor_values(memory, addresses, items);
+    std::reverse(items.begin(), items.end());
+}
+
+void BankKind::load_items
+    (const MemoryReader & memory, const ItemGlobals & globals, const AddressList & addresses,
+     ItemValueList & items) const
+{
+    load_bank_values(memory, globals, addresses, items);
+    std::sort(items.begin(), items.end(), lhs_code_lt_rhs);
+}
+
+/* protected */ StringWriter::int_type StringWriter::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    m_target.push_back(traits_type::to_char_type(ch));
+    return ch;
+}
+
+/* protected */ std::streamsize StringWriter::xsputn
+    (const char * str, std::streamsize count)
+{
+    m_target.append(str, std::size_t(count));
+    return count;
+}
+
+} // end of <anonymous> namespace
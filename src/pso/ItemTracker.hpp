@@ -0,0 +1,172 @@
+/****************************************************************************
+
+    File: ItemTracker.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "ItemReader.hpp"
+#include "ItemValue.hpp"
+
+#include "../ReadPlanner.hpp"
+
+#include <string>
+#include <unordered_map>
+
+/** Which items a list holds: where their records are, and how they are
+ *  decoded and ordered. Instances hold no state, and so may be shared by
+ *  any number of threads.
+ */
+class ItemListKind {
+public:
+    virtual ~ItemListKind() {}
+
+    virtual void load_addresses
+        (const MemoryReader &, const ItemGlobals &, AddressList &) const = 0;
+
+    /** Decodes every item into items (which is cleared first), in display
+     *  order.
+     */
+    virtual void load_items
+        (const MemoryReader &, const ItemGlobals &, const AddressList &,
+         ItemValueList & items) const = 0;
+
+    /** Decodes a single item out of its record (the bytes hashed), for
+     *  reloading only those whose records changed. Anything outside of the
+     *  record is read from memory.
+     *  @returns false if the record could not be decoded
+     */
+    virtual bool decode_item
+        (const ByteSpan & record, Address, const MemoryReader &, ItemValue &) const = 0;
+
+    /** @returns the part of each item's record hashed to tell if it changed */
+    virtual RecordSpan record_span() const noexcept = 0;
+
+    /** @returns true if items are shown in the reverse of the order
+     *           load_addresses gives their addresses in, otherwise they're
+     *           sorted by item code
+     */
+    virtual bool in_reverse_address_order() const noexcept { return false; }
+
+    /** @returns seconds between full reloads, for lists with parts outside
+     *           of the hashed records, zero for never
+     */
+    virtual double full_reload_interval() const noexcept { return 0.; }
+
+    static const ItemListKind & inventory();
+    static const ItemListKind & floor    ();
+    static const ItemListKind & bank     ();
+};
+
+/** An item as a tracker keeps it, decoded and formatted once and then only
+ *  again when its record changes.
+ */
+struct TrackedItem {
+    ItemValue item;
+    // the item printed, in the items' color markup
+    std::string line;
+    // of the record the item was decoded from
+    uint64_t record_hash = 0;
+    // of the last update which found the item still listed
+    unsigned generation = 0;
+};
+
+/** Keeps one list of items up to date from update to update.
+ *
+ *  Items are cached by the address of their record, along with a hash of
+ *  it. An update hashes every listed record, and only decodes and formats
+ *  items whose address is new or whose record's hash changed, inserting
+ *  them into place in the display order. So picking up or dropping an item
+ *  costs one decode, not a reload of the whole list.
+ *
+ *  Every buffer is kept from update to update, so that once warmed up
+ *  updates with nothing coming or going make no heap allocations.
+ */
+class ItemTracker {
+public:
+    explicit ItemTracker(const ItemListKind &);
+
+    /** @throws as the list kind's loaders do
+     *  @returns true if any item changed
+     */
+    bool update(const MemoryReader &, const ItemGlobals &, double elapsed_time);
+
+    /** Loads every item anew. @throws as the list kind's loaders do */
+    void reload(const MemoryReader &, const ItemGlobals &);
+
+    const ItemListKind & kind() const noexcept { return *m_kind; }
+
+    /** @returns every item, in display order */
+    const std::vector<const TrackedItem *> & items() const noexcept { return m_order; }
+
+    /** @returns addresses of the listed items, in the order the list kind
+     *           loads them
+     */
+    const AddressList & addresses() const noexcept { return m_pointers; }
+
+private:
+    using ItemCache = std::unordered_map<Address, TrackedItem>;
+
+    void reload_all_items(const MemoryReader &, const ItemGlobals &);
+
+    /** @returns true if any item changed */
+    bool reload_changed_items(const MemoryReader &, const ItemGlobals &);
+
+    /** Hashes the record of each item in m_pointers, all read at once, into
+     *  m_record_hashes.
+     *  @returns false if any record could not be read
+     */
+    bool hash_records(const MemoryReader &);
+
+    /** Puts a new or changed item into the cache, and formats it. */
+    TrackedItem & cache_item(Address, ItemValue &&, uint64_t record_hash);
+
+    /** Removes every item not seen by the current generation.
+     *  @returns true if any were removed
+     */
+    bool drop_unlisted_items();
+
+    /** Places a new or changed item where it belongs in display order,
+     *  unless the list is in address order (which is redone all at once).
+     */
+    void place_item(const TrackedItem &);
+
+    void unplace_item(const TrackedItem &);
+
+    /** Redoes the display order from the addresses, for lists in (reverse)
+     *  address order.
+     */
+    void reorder_by_address();
+
+    const ItemListKind * m_kind;
+    bool m_loaded = false;
+    double m_since_reload = 0.;
+    unsigned m_generation = 0;
+
+    AddressList m_pointers;
+    // one per pointer, in the same order
+    std::vector<uint64_t> m_record_hashes;
+    ReadPlanner           m_record_planner;
+
+    ItemCache m_cache;
+    std::vector<const TrackedItem *> m_order;
+
+    // full reloads only
+    ItemValueList m_loaded_items;
+};
@@ -0,0 +1,72 @@
+/****************************************************************************
+
+    File: ItemValue.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include "ItemReader.hpp"
+#include "Item.hpp"
+
+#include <variant>
+
+/** An item of any kind, held by value. A list of these is one contiguous
+ *  block, so decoding into a list which is kept between refreshes makes no
+ *  heap allocations, and printing and decoding dispatch through
+ *  std::visit rather than the vtable.
+ */
+using ItemValue = std::variant<
+    Weapon, EsWeapon, Frame, Barrier, Unit, Mag, Tool, Tech, Meseta,
+    TotallyUnknownItem>;
+
+using ItemValueList = std::vector<ItemValue>;
+
+/** As load_bank, load_inventory and load_floor, but decoding into the given
+ *  list (which is cleared first), keeping its storage.
+ */
+void load_bank_values     (const MemoryReader &, const ItemGlobals &, const AddressList &, ItemValueList &);
+void load_inventory_values(const MemoryReader &, const AddressList &, ItemValueList &);
+void load_floor_values    (const MemoryReader &, const AddressList &, ItemValueList &);
+
+/** As load_inventory_item and load_bank_item, but decoding into the given
+ *  item.
+ *  @returns false (leaving the item as it was) if the record could not be
+ *           decoded
+ */
+bool load_inventory_value(const MemoryReader &, Address, ItemValue &);
+bool load_bank_value     (const MemoryReader &, Address, ItemValue &);
+
+/** Decodes the item whose record is at the given address out of bytes
+ *  copied from the target, without reading the record (see
+ *  Item::load_from).
+ *  @param fallback if given, for the one field outside of the record (a
+ *                  bank item's kill counter)
+ *  @returns false (leaving the item as it was) if the bytes do not hold the
+ *           whole record (or a bank item's kill counter, without a
+ *           fallback), a read of the fallback failed, or the record holds
+ *           junk (like a special or tech code out of range)
+ */
+bool decode_inventory_value(const ByteSpan &, Address, ItemValue &, const MemoryReader * fallback = nullptr);
+bool decode_bank_value     (const ByteSpan &, Address, ItemValue &, const MemoryReader * fallback = nullptr);
+
+inline const Item & as_item(const ItemValue & value)
+    { return std::visit([](const Item & item) -> const Item & { return item; }, value); }
+
+inline void print_item(std::ostream & out, const ItemValue & value)
+    { std::visit([&out](const auto & item) { item.print_to(out); }, value); }
@@ -21,17 +21,58 @@
 
 #include "ProcessWatcher.hpp"
 #include "ItemReaderStates.hpp"
+#include "ClientWorker.hpp"
 #include "../MemoryReader.hpp"
+#include "../SnapshotMemoryReader.hpp"
+#include "../RecordingMemoryReader.hpp"
+#include "../CaptureFile.hpp"
+#include "../FaultInjectingMemoryReader.hpp"
 
 #include "../Defs.hpp"
 
+#include <algorithm>
 #include <fstream>
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <cassert>
 
 namespace {
 
+MemoryReader::ProcessReadMethod get_read_method();
+
+/** @param suffix added to the recording's filename, so that each client
+ *         gets its own
+ *  @returns a reader for the process, which is also recorded if asked for
+ */
+std::shared_ptr<const MemoryReader> make_reader(int pid, const std::string & suffix);
+
+/** @param suffix as with make_reader
+ *  @returns a capture to write to, if asked for (nullptr otherwise)
+ */
+std::shared_ptr<CaptureWriter> make_capture(const std::string & suffix);
+
+/** @returns the pid of every running client, empty if there are none (or
+ *           they could not be listed)
+ */
+std::vector<int> find_client_pids();
+
+/** Attaches a worker to each process clients does not hold yet, and fetches
+ *  its first list of items before starting it (so that permission problems
+ *  surface here). Processes which cannot be read yet are left out.
+ *  @throws PermissionError
+ */
+void attach_clients(ClientSet & clients, const std::vector<int> & pids);
+
+/** @returns a reader standing in for a live process (a snapshot, a
+ *           replay or a capture) if the environment asks for one, nullptr otherwise
+ */
+std::shared_ptr<const MemoryReader> make_offline_reader();
+
+/** @returns the reader, with faults injected if asked for */
+std::shared_ptr<const MemoryReader> with_requested_faults(std::shared_ptr<const MemoryReader>);
+
 auto popen_to_uptr(const char * command, const char * mode) {
     struct ClosePFile
         { void operator () (FILE * ptr) const { (void)pclose(ptr); } };
@@ -73,31 +114,28 @@ void PsobbProcessWatcher::render_to(TargetGrid & target) const {
 }
 
 void PsobbProcessWatcher::handle_tick(double) {
-    static constexpr const int k_read_size = 1024;
-    auto pfile = popen_to_uptr("pgrep psobb", "r");
-    // oh well, try again later
-    if (!pfile) return;
-
-    std::string contents;
-    std::array<char, k_read_size> buf {};
-    while (fgets(buf.data(), k_read_size, pfile.get())) {
-        contents += buf.data();
+    try {
+        if (auto offline = make_offline_reader()) {
+            switch_state<BankViewState>().setup(offline);
+            return;
+        }
+    } catch (std::exception & ex) {
+        std::ofstream fout("error.txt");
+        fout << ex.what() << std::endl;
+        throw QuitAppException();
     }
 
     try {
-        int pid = k_no_pid;
-        auto beg = contents.begin();
-        auto end = contents.end();
-        trim<is_whitespace>(beg, end);
-        if (string_to_number_multibase(beg, end, pid)) {
-            switch_state<BankViewState>().setup(
-                MemoryReader::make_process_reader(pid));
+        auto pids = find_client_pids();
+        if (!pids.empty()) {
+            auto clients = std::make_shared<ClientSet>();
+            attach_clients(*clients, pids);
+            switch_state<BankViewState>().setup(clients);
         }
     } catch (PermissionError &) {
-        m_has_permission = false;
-        update_bad_permission_message();
         [[maybe_unused]] auto * stateptr = &switch_state<PsobbProcessWatcher>();
         assert(this == stateptr);
+        report_bad_permission();
     } catch (std::exception & ex) {
         std::ofstream fout("error.txt");
         fout << ex.what() << std::endl;
@@ -111,6 +149,19 @@ void PsobbProcessWatcher::handle_resize(const GridSize & gsize) {
     update_bad_permission_message();
 }
 
+/* free fn */ void attach_new_clients(ClientSet & clients) {
+    auto pids = find_client_pids();
+    // only those which aren't held already cost anything
+    pids.erase(std::remove_if(pids.begin(), pids.end(),
+        [&clients](int pid) { return clients.contains(pid); }), pids.end());
+    attach_clients(clients, pids);
+}
+
+void PsobbProcessWatcher::report_bad_permission() {
+    m_has_permission = false;
+    update_bad_permission_message();
+}
+
 void PsobbProcessWatcher::update_bad_permission_message() {
     if (m_has_permission) return;
     static const std::vector<std::string> k_perm_fail = {
@@ -123,3 +174,111 @@ void PsobbProcessWatcher::update_bad_permission_message() {
     };
     render_wrapped_lines_to(k_perm_fail, m_max_width, m_max_height, m_error_lines);
 }
+
+namespace {
+
+MemoryReader::ProcessReadMethod get_read_method() {
+    // e.g. APIR_READ_METHOD=proc-mem ./apir
+    const char * method = std::getenv("APIR_READ_METHOD");
+    if (method && std::strcmp(method, "proc-mem") == 0) {
+        return MemoryReader::k_proc_pid_mem;
+    }
+    return MemoryReader::k_process_vm_readv;
+}
+
+std::shared_ptr<const MemoryReader> make_reader(int pid, const std::string & suffix) {
+    // faults come first, so that recordings replay them
+    auto reader = with_requested_faults(MemoryReader::make_process_reader(pid, get_read_method()));
+    // e.g. APIR_RECORD=session.apirrec ./apir
+    if (const char * recording = std::getenv("APIR_RECORD")) {
+        return std::make_shared<RecordingMemoryReader>(reader, recording + suffix);
+    }
+    return reader;
+}
+
+std::shared_ptr<const MemoryReader> make_offline_reader() {
+    // e.g. APIR_SNAPSHOT=snapshot.apir ./apir, for replaying offline
+    if (const char * snapshot = std::getenv("APIR_SNAPSHOT")) {
+        return with_requested_faults(std::make_shared<SnapshotMemoryReader>(snapshot));
+    }
+    // e.g. APIR_REPLAY=session.apirrec APIR_REPLAY_SPEED=4 ./apir
+    if (const char * replay = std::getenv("APIR_REPLAY")) {
+        const char * speed = std::getenv("APIR_REPLAY_SPEED");
+        return with_requested_faults(
+            std::make_shared<ReplayMemoryReader>(replay, speed ? std::atof(speed) : 1.));
+    }
+    // e.g. APIR_CAPTURE_REPLAY=session.apircap APIR_CAPTURE_SEEK=600 ./apir
+    if (const char * capture = std::getenv("APIR_CAPTURE_REPLAY")) {
+        auto reader = std::make_shared<CaptureReader>(capture);
+        if (const char * seek = std::getenv("APIR_CAPTURE_SEEK")) {
+            reader->seek(std::atof(seek));
+        }
+        return with_requested_faults(reader);
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const MemoryReader> with_requested_faults
+    (std::shared_ptr<const MemoryReader> reader)
+{
+    // e.g. APIR_FAULTS=latency=0.0005,bad=0.01,torn=0.01 ./apir
+    const char * settings = std::getenv("APIR_FAULTS");
+    if (!settings) return reader;
+    return std::make_shared<FaultInjectingMemoryReader>
+        (std::move(reader), FaultProfile::parse(settings));
+}
+
+std::shared_ptr<CaptureWriter> make_capture(const std::string & suffix) {
+    // e.g. APIR_CAPTURE=session.apircap ./apir
+    if (const char * capture = std::getenv("APIR_CAPTURE")) {
+        return std::make_shared<CaptureWriter>(capture + suffix);
+    }
+    return nullptr;
+}
+
+std::vector<int> find_client_pids() {
+    static constexpr const int k_read_size = 1024;
+    auto pfile = popen_to_uptr("pgrep psobb", "r");
+    // oh well, try again later
+    if (!pfile) return std::vector<int>();
+
+    std::string contents;
+    std::array<char, k_read_size> buf {};
+    while (fgets(buf.data(), k_read_size, pfile.get())) {
+        contents += buf.data();
+    }
+
+    // one pid per line, one line per running client
+    std::vector<int> pids;
+    for_split<is_newline>(contents.data(), contents.data() + contents.size(),
+        [&pids](const char * beg, const char * end)
+    {
+        int pid = k_no_pid;
+        trim<is_whitespace>(beg, end);
+        if (string_to_number_multibase(beg, end, pid)) pids.push_back(pid);
+    });
+    return pids;
+}
+
+void attach_clients(ClientSet & clients, const std::vector<int> & pids) {
+    for (int pid : pids) {
+        if (clients.contains(pid)) continue;
+        auto pidstr = std::to_string(pid);
+        // a lone client's files keep the names they were given
+        auto suffix = pids.size() > 1 || !clients.empty() ? "." + pidstr : std::string();
+        auto client = std::make_shared<ClientWorker>
+            (make_reader(pid, suffix), "pid " + pidstr, make_capture(suffix), pid);
+        try {
+            client->step(0.);
+        } catch (PermissionError &) {
+            throw;
+        } catch (...) {
+            // probably exiting, or not yet loaded, try again next time
+            continue;
+        }
+        client->start();
+        clients.add(std::move(client));
+    }
+}
+
+} // end of <anonymous> namespace
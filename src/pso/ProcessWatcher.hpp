@@ -23,6 +23,8 @@
 
 #include "../AppStateDefs.hpp"
 
+class ClientSet;
+
 class PsobbProcessWatcher final : public AppState {
 public:
     void handle_event(const Event &) override;
@@ -32,6 +34,12 @@ public:
     UpdateStyle update_style() const noexcept override {
         return m_has_permission ? k_continuous_updates : k_until_next_event;
     }
+
+    /** Shows how to grant ptrace permission, rather than searching for
+     *  clients (for when reading one was refused).
+     */
+    void report_bad_permission();
+
 private:
     void update_bad_permission_message();
     bool m_has_permission = true;
@@ -39,3 +47,11 @@ private:
 
     std::vector<std::string> m_error_lines;
 };
+
+/** Attaches to every client started since the set was attached, leaving
+ *  those it already holds alone. Clients which cannot be read yet are left
+ *  for the next call. Runs pgrep, so it's meant for now and then (the item
+ *  views call it once a second).
+ *  @throws PermissionError
+ */
+void attach_new_clients(ClientSet &);